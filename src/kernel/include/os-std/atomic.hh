@@ -36,6 +36,8 @@ namespace ostd {
                                                             ,int order_fail    = atomic_default_order)
                                                             { return __atomic_compare_exchange(&x, &expected, &y, false, order_success, order_fail); }
 
+    template<typename T> constexpr T atomic_exchange(T &x, T y, int order = atomic_default_order) { return __atomic_exchange_n(&x, y, order); }
+
     template<typename T> constexpr void atomic_load (const T &x, T &y, int order = atomic_default_order) { __atomic_load (&x, &y, order); }
     template<typename T> constexpr void atomic_store(T &x, const T &y, int order = atomic_default_order) { __atomic_store(&x, &y, order); }
 
@@ -50,6 +52,7 @@ namespace ostd {
         //         ||  is_pointer<T>::value), T>::type
 
         bool compare_exchange(T &expected, T desired) { return atomic_compare_exchange(val, expected, desired); }
+        T    exchange(T desired)                      { return atomic_exchange(val, desired); }
 
         T load() const { T x; atomic_load (val, x); return x; }
         T store(T x)   {      atomic_store(val, x); return x; }
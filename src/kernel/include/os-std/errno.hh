@@ -33,6 +33,7 @@ namespace ostd {
     static constexpr errno_t ERR_perm          = -12;
     static constexpr errno_t ERR_not_supported = -13;
     static constexpr errno_t ERR_in_use        = -14;
+    static constexpr errno_t ERR_again         = -15;
     static constexpr errno_t ERR_eof           = errno_t(1ULL << (sizeof(errno_t)*8-1));
 
     constexpr StringView error_name(errno_t err) {
@@ -51,7 +52,8 @@ namespace ostd {
             ,            "operation timed out"
             ,            "operation not permitted"
             ,            "operation not supported"
-            ,            "resource is in use" };
+            ,            "resource is in use"
+            ,            "resource temporarily unavailable" };
 
         if (err >= ERR_success)
              return "success";
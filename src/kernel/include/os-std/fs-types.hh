@@ -65,6 +65,17 @@ static constexpr open_flags_t o_create   = 1 << 4;
 static constexpr open_flags_t o_dir      = 1 << 5;
 /// @}
 
+/// \name Poll events
+/// @{
+
+using poll_events_t = u32;
+
+static constexpr poll_events_t poll_in   = 1 << 0; ///< Can be read without blocking.
+static constexpr poll_events_t poll_out  = 1 << 1; ///< Can be written without blocking.
+static constexpr poll_events_t poll_hup  = 1 << 2; ///< The other side hung up (e.g. a pipe end was closed).
+static constexpr poll_events_t poll_nval = 1 << 3; ///< Invalid file descriptor.
+/// @}
+
 enum seek_t {
     seek_set = 0,
     seek_end,
@@ -42,9 +42,30 @@ namespace ostd {
     /// Max length of a process name.
     static constexpr size_t max_proc_name        = 32;
 
+    /// Max amount of buffer segments in one vectored read / write.
+    static constexpr size_t max_iovecs           =  16;
+
+    /// Amount of entries in an I/O submission ring (a power of two).
+    static constexpr size_t io_ring_sq_entries   =  64;
+
+    /// Amount of entries in an I/O completion ring (a power of two).
+    static constexpr size_t io_ring_cq_entries   = 128;
+
     /// Max amount of process arguments.
     static constexpr size_t max_args             = 32;
 
     /// Max total amount of chars in a process' arguments.
     static constexpr size_t max_args_chars       = 1024;
+
+    /// Max IPC ports across all processes.
+    static constexpr size_t max_ports            =  64;
+
+    /// Max length of an IPC port name.
+    static constexpr size_t max_port_name        =  32;
+
+    /// Max size of the inline (copied) part of an IPC message.
+    static constexpr size_t ipc_inline_max       = 8192; // 8K
+
+    /// Page-aligned IPC payloads of at least this size are remapped instead of copied.
+    static constexpr size_t ipc_remap_threshold  = 8192; // 8K
 }
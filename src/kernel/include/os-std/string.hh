@@ -440,6 +440,19 @@ namespace ostd {
         }
     }
 
+    /**
+     * Hash a string (FNV-1a), for use in hash tables.
+     *
+     * Pass the result of a previous call as `h` to hash multiple strings as one.
+     */
+    constexpr inline u32 str_hash(StringView s, u32 h = 2166136261u) {
+        for (char c : s) {
+            h ^= (u8)c;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
     /// Parse a string into a u64. Returns false on parse error.
     constexpr inline bool string_to_u64(StringView s, u64 &v) {
         v = 0;
@@ -0,0 +1,54 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "os-std/types.hh"
+
+/**
+ * \file
+ * Scheduler trace record format.
+ *
+ * The kernel records scheduler events in a ring buffer, which can be read
+ * from /dev/sched-trace as a stream of sched_trace_event_t structures.
+ * Reading consumes events: Every read returns only whole records.
+ */
+
+enum sched_trace_type_t : u8 {
+    sched_ev_enqueue    = 0, ///< Thread was added to the ready queue.
+    sched_ev_wakeup     = 1, ///< Blocked thread was made ready (unblock).
+    sched_ev_switch_in  = 2, ///< Thread was dispatched.   (arg = previous TID)
+    sched_ev_switch_out = 3, ///< Thread stopped running.  (arg = next TID)
+    sched_ev_block      = 4, ///< Thread blocked.          (arg = wait site address)
+};
+
+enum sched_trace_reason_t : u8 {
+    sched_reason_none    = 0,
+    sched_reason_preempt = 1, ///< Timeslice expired.
+    sched_reason_yield   = 2, ///< Thread voluntarily gave up the CPU.
+    sched_reason_block   = 3, ///< Thread is waiting on something.
+    sched_reason_exit    = 4, ///< Thread was deleted.
+};
+
+struct sched_trace_event_t {
+    u64 tsc;      ///< Timestamp counter value at the time of the event.
+    u32 tid;      ///< The thread this event applies to.
+    u32 pid;      ///< The process of that thread.
+    u8  type;     ///< A sched_trace_type_t.
+    u8  reason;   ///< A sched_trace_reason_t.
+    u16 reserved;
+    u32 arg;      ///< Event-specific argument (see sched_trace_type_t).
+};
+
+static_assert(sizeof(sched_trace_event_t) == 24, "sched trace record layout changed");
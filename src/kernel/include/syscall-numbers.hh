@@ -44,6 +44,29 @@ enum syscall_t {
     SYS_SET_CWD       = 13,
     SYS_DUPLICATE_FD  = 14,
     SYS_PIPE          = 15,
+    SYS_THREAD_CREATE = 16,
+    SYS_FUTEX_WAIT    = 17,
+    SYS_FUTEX_WAKE    = 18,
+    SYS_PORT_CREATE   = 19,
+    SYS_PORT_DESTROY  = 20,
+    SYS_PORT_LOOKUP   = 21,
+    SYS_PORT_SEND     = 22,
+    SYS_PORT_RECEIVE  = 23,
+    SYS_PORT_CALL     = 24,
+    SYS_PORT_REPLY    = 25,
+    SYS_POLL          = 26,
+    SYS_READV         = 27,
+    SYS_WRITEV        = 28,
+    SYS_RING_SETUP    = 29,
+    SYS_RING_ENTER    = 30,
+    SYS_GET_DENTS     = 31,
+    SYS_STAT          = 32,
+    SYS_FSTAT         = 33,
+    SYS_COPY_RANGE    = 34,
+    SYS_SYNC          = 35,
+    SYS_FSYNC         = 36,
+
+    SYS_COUNT ///< The amount of system calls (keep this last).
 };
 
 /**
@@ -91,6 +114,14 @@ struct syscall_dir_entry_t {
     u64     size    = 0;
 };
 
+/// File metadata, as returned by SYS_STAT and SYS_FSTAT.
+struct syscall_stat_t {
+    u64     inode_i = 0;
+    ftype_t type    = t_regular;
+    perm_t  perm    = 0;
+    u64     size    = 0;
+};
+
 /// Argument structure for spawning processes.
 struct syscall_spawn_args_t {
 
@@ -111,6 +142,120 @@ struct syscall_spawn_args_t {
     bool do_wait = false;
 };
 
+/// A buffer segment for vectored I/O (readv / writev).
+struct syscall_iovec_t {
+    void  *data;
+    size_t size;
+};
+
+/// Argument structure for poll: one per polled file.
+struct syscall_poll_fd_t {
+    fd_t          fd;
+    poll_events_t events  = 0; ///< Events to wait for.
+    poll_events_t revents = 0; ///< Events that occurred (poll_hup and poll_nval are always reported).
+};
+
+/// I/O ring operations. Arguments map onto those of the equivalent syscalls.
+enum io_ring_op_t : u32 {
+    io_op_nop = 0,
+    io_op_read,  ///< fd, data, size           => bytes read
+    io_op_write, ///< fd, data, size           => bytes written
+    io_op_seek,  ///< fd, flags (whence), offset => err
+    io_op_open,  ///< fd (-1: any), data (path), size (path length), flags => fd
+    io_op_close, ///< fd                       => err
+};
+
+/// An I/O ring submission entry.
+struct syscall_io_sqe_t {
+    io_ring_op_t op;
+    fd_t         fd;
+    void        *data;
+    size_t       size;
+    s32          offset;
+    u32          flags;
+    u32          user_data; ///< Copied into the completion entry.
+    u32          _reserved;
+};
+
+/// An I/O ring completion entry.
+struct syscall_io_cqe_t {
+    u32 user_data;
+    s32 result;    ///< The result of the operation, as returned by the equivalent syscall.
+};
+
+/// Set in the submission ring flags when the kernel worker sleeps:
+/// SYS_RING_ENTER must be called to have new submissions processed.
+static constexpr u32 io_ring_need_wakeup = 1 << 0;
+
+/**
+ * An I/O submission/completion ring pair, shared between a process and the
+ * kernel.
+ *
+ * The process fills submission entries and then advances `tail`. A kernel
+ * worker thread processes entries in order, and posts completions to the
+ * completion ring. The process consumes completions by advancing its `head`.
+ *
+ * Indices are free-running: entry i lives at [i % entries].
+ *
+ * Each ring occupies its own page.
+ */
+struct syscall_io_ring_t {
+    struct alignas(ostd::page_size) {
+        u32 head;  ///< Written by the kernel.
+        u32 tail;  ///< Written by the process.
+        u32 flags; ///< io_ring_need_wakeup. Written by the kernel.
+        syscall_io_sqe_t entries[ostd::io_ring_sq_entries];
+    } sq;
+
+    struct alignas(ostd::page_size) {
+        u32 head;  ///< Written by the process.
+        u32 tail;  ///< Written by the kernel.
+        syscall_io_cqe_t entries[ostd::io_ring_cq_entries];
+    } cq;
+};
+
+/**
+ * The kernel data page, mapped read-only into every process (at KERNEL_DATA_,
+ * see libsys' linker script).
+ *
+ * It lets processes obtain their IDs and the time without a system call.
+ *
+ * The time fields are updated while the process runs. Since the process may
+ * be interrupted halfway through reading them, the kernel increments `seq`
+ * on every update: Readers retry if it changed while they were reading.
+ */
+struct syscall_kernel_data_t {
+    u32   seq;          ///< Update counter.
+    pid_t pid;          ///< The process' ID.
+    tid_t main_tid;     ///< The ID of the process' main thread.
+    u32   tick_hz;      ///< Timer ticks per second.
+    u64   ticks;        ///< Timer ticks since boot.
+    u64   tick_tsc;     ///< Time stamp counter value at the last timer tick.
+    u32   tsc_per_tick; ///< Time stamp counter increments per tick, 0 if not (yet) calibrated.
+};
+
+/**
+ * An IPC message, as sent to or received from a port.
+ *
+ * A message consists of a tag, up to ipc_inline_max bytes of inline data
+ * (which are copied) and an optional page-aligned payload (of which the
+ * pages are moved to the receiving buffer, rather than copied).
+ *
+ * When sending, sizes describe the data to send. When receiving, sizes
+ * describe buffer capacities on input, and received amounts on output.
+ */
+struct syscall_message_t {
+    u32    id         = 0;       ///< Set on receive: call ID to reply to (0 if not a call).
+    pid_t  sender     = 0;       ///< Set on receive: the sending process.
+    u32    tag        = 0;       ///< Message type, meaning is up to the user.
+
+    void  *data       = nullptr; ///< Inline data.
+    size_t size       = 0;
+
+    void  *pages      = nullptr; ///< Page-aligned payload.
+    size_t pages_size = 0;       ///< (must be a multiple of the page size)
+};
+
 /**
  * @}
  */
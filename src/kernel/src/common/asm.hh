@@ -85,6 +85,15 @@ inline u32  asm_rdrand() {
     return r;
 }
 
+/// \name Model-specific registers.
+///@{
+inline u64  asm_rdmsr(u32 msr) { u32 hi, lo;
+                                 asm volatile ("rdmsr" : "=d" (hi), "=a" (lo) : "c" (msr));
+                                 return ((u64)hi << 32) | lo; }
+inline void asm_wrmsr(u32 msr, u64 x) {
+                                 asm volatile ("wrmsr" :: "c" (msr), "d" ((u32)(x >> 32)), "a" ((u32)x)); }
+///@}
+
 inline void asm_invlpg(addr_t x) {
     asm volatile ("invlpg (%0)" :: "a" (x) : "memory");
 }
@@ -57,6 +57,11 @@ namespace Driver::Disk::Ata {
     /// LBAs can be 28 or 48-bit. 64 1-bits is never a valid LBA.
     static constexpr u64 invalid_lba = intmax<u64>::value;
 
+    /// Blocks transferred per read/write command (the sector count register
+    /// is 8 bits wide). Larger transfers are split up, so that the bus is not
+    /// held for too long.
+    static constexpr size_t max_blocks_per_command = 64;
+
     struct dev_t : public DevFs::device_t {
 
         u8   bus_i;
@@ -69,6 +74,9 @@ namespace Driver::Disk::Ata {
             if (nbytes % block_size)            return ERR_io;
             if (offset >= max_lba * block_size) return 0;
 
+            // Reads past the end of the disk are cut short.
+            nbytes = min(u64(nbytes), max_lba * block_size - offset);
+
             errno_t err = Driver::Disk::Ata::read(bus_i*2+drive_i
                                                  ,offset / block_size
                                                  ,(u8*)buffer
@@ -144,9 +152,13 @@ namespace Driver::Disk::Ata {
         bus_t  &bus  = buses[bus_i];
         disk_t &disk = *bus.disks[drive_i];
 
-        for (size_t i : range(block_count)) {
-            if (lba + i >= disk.max_lba)
-                return ERR_io;
+        if (lba + block_count > disk.max_lba)
+            return ERR_io;
+
+        // Transfer multiple blocks per command: Issuing a command per block
+        // costs far more than the PIO data transfer itself.
+        for (size_t i = 0; i < block_count; i += max_blocks_per_command) {
+            u8 count = min(block_count - i, max_blocks_per_command);
 
             mutex_lock(bus.lock);
 
@@ -161,24 +173,25 @@ namespace Driver::Disk::Ata {
                                                 ,drive_i
                                                 ,lba    + i
                                                 ,buffer + i*block_size
-                                                ,1);
+                                                ,count);
                 } else {
                     err = Protocol::read_blocks(bus_i
                                                ,drive_i
                                                ,lba    + i
                                                ,buffer + i*block_size
-                                               ,1);
+                                               ,count);
                 }
             } while (err == ERR_timeout && retries++ < 10);
 
             if (err < 0) {
                 mutex_unlock(bus.lock);
-                Process::yield();
                 return err;
             }
 
             mutex_unlock(bus.lock);
-            Process::yield();
+
+            // Give other threads a chance if this transfer is taking long.
+            Process::preempt_point();
         }
 
         return ERR_success;
@@ -18,7 +18,7 @@
 #include "ps2/protocol.hh"
 #include "ps2/scancodes.hh"
 #include "filesystem/vfs.hh"
-#include "ipc/queue.hh"
+#include "ipc/spsc-queue.hh"
 
 #include "../../kshell.hh"
 
@@ -50,8 +50,8 @@ namespace Driver::Input::Ps2 {
         u8 buttons;
     };
 
-    KQueue<mouse_event_t, 32> mouse_events;
-    KQueue<char, 32>          keyboard_input;
+    SpscQueue<mouse_event_t, 32> mouse_events;
+    SpscQueue<char, 32>          keyboard_input;
 
     /// Interrupt handler for keyboard events.
     static void irq_handler_keyboard(const interrupt_frame_t &) {
@@ -203,6 +203,10 @@ namespace Driver::Input::Ps2 {
             return ERR_nospace;
         }
         s64 size() override { return 0; }
+
+        poll_events_t poll(Poll::waitq_t *&queue) override {
+            return mouse_events.poll(queue);
+        }
     };
     static mouse_dev_t mouse_dev;
 
@@ -237,6 +241,10 @@ namespace Driver::Input::Ps2 {
             return ERR_nospace;
         }
         s64 size() override { return 0; }
+
+        poll_events_t poll(Poll::waitq_t *&queue) override {
+            return keyboard_input.poll(queue);
+        }
     };
     static keyboard_dev_t keyboard_dev;
 
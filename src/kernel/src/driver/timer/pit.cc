@@ -15,6 +15,8 @@
 #include "pit.hh"
 #include "../../interrupt/handlers.hh"
 #include "../../process/proc.hh"
+#include "../../ipc/poll.hh"
+#include "../../process/kernel-data.hh"
 
 DRIVER_NAME("pit");
 
@@ -22,30 +24,36 @@ namespace Driver::Timer::Pit {
 
     using namespace Interrupt;
 
-    static u64 ticks                  = 0;
+    static u64 ticks_                 = 0;
     static u64 ticks_in_current_slice = 0;
 
     static u64 i = 0;
 
-    static void irq_handler(const interrupt_frame_t&) {
+    static void irq_handler(const interrupt_frame_t &frame) {
 
-        ++ticks;
+        ++ticks_;
         ++ticks_in_current_slice;
 
+        Poll::timer_tick(ticks_);
+        Process::KernelData::timer_tick(ticks_);
+
         // Switch threads if a timeslice is used up.
         if (Process::scheduler_enabled()) {
             if (ticks_in_current_slice >= Process::ticks_per_slice) {
 
                 ticks_in_current_slice = 0;
-                Process::yield_noreturn();
+                Process::timeslice_expired(frame);
             } else {
                 ++Process::current_thread()->ticks_running;
             }
         }
     }
 
+    u64 ticks() { return ticks_; }
+
     void init() {
         // XXX temporary - sets PIT frequency to 1 KHz.
+        static_assert(tick_hz == 1000);
         Io::out_8s(0x43, 0x34);
         // Io::out_8s(0x40, (8*1193) & 0xff);
         // Io::out_8 (0x40, (8*1193) >> 8);
@@ -23,5 +23,11 @@
  */
 namespace Driver::Timer::Pit {
 
+    /// Timer tick frequency.
+    constexpr u32 tick_hz = 1000;
+
+    /// Timer ticks since boot (the PIT runs at 1 kHz, so these are milliseconds).
+    u64 ticks();
+
     void init();
 }
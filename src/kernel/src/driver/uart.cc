@@ -17,7 +17,7 @@
 #include "../console/serial.hh"
 #include "../debug-keys.hh"
 #include "filesystem/vfs.hh"
-#include "ipc/queue.hh"
+#include "ipc/spsc-queue.hh"
 #include "process/proc.hh"
 
 #include "../kshell.hh"
@@ -28,7 +28,7 @@ namespace Driver::Uart {
 
     using namespace Interrupt;
 
-    KQueue<char, 32> uart_input;
+    SpscQueue<char, 32> uart_input;
 
     static void irq_handler(const interrupt_frame_t &) {
         char ch = Io::in_8(0x3f8);
@@ -106,6 +106,10 @@ namespace Driver::Uart {
             return written;
         }
         s64 size() override { return 0; }
+
+        poll_events_t poll(Poll::waitq_t *&queue) override {
+            return uart_input.poll(queue) | poll_out;
+        }
     };
     static uart_dev_t uart_dev;
 
@@ -0,0 +1,100 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "dcache.hh"
+#include "filesystem.hh"
+
+namespace Vfs::Dcache {
+
+    struct dentry_t {
+        FileSystem::Fs *fs     = nullptr; ///< nullptr if this entry is unused.
+        u64             parent = 0;       ///< The directory's inode number.
+        file_name_t     name;
+        errno_t         err    = ERR_success;
+        inode_t         inode;
+        u32             used   = 0;       ///< For LRU replacement.
+    };
+
+    /// The cache is set-associative: A name can live in any of the entries of one set.
+    static constexpr size_t set_count = 128; ///< (must be a power of two)
+    static constexpr size_t set_ways  = 4;
+
+    static Array<Array<dentry_t, set_ways>, set_count> sets;
+
+    static u32 clock = 0;
+
+    static Array<dentry_t, set_ways> &set_of(const inode_t &parent, StringView name) {
+        u32 h = str_hash(name, (u32)parent.i * 16777619u ^ (u32)(addr_t)parent.fs);
+        return sets[h & (set_count - 1)];
+    }
+
+    static dentry_t *find_entry(const inode_t &parent, StringView name) {
+        for (dentry_t &e : set_of(parent, name)) {
+            if (e.fs == parent.fs && e.parent == parent.i && e.name == name)
+                return &e;
+        }
+        return nullptr;
+    }
+
+    bool find(const inode_t &parent, StringView name, inode_t &dest, errno_t &err) {
+
+        dentry_t *e = find_entry(parent, name);
+        if (!e) return false;
+
+        e->used = ++clock;
+        err     = e->err;
+        if (err == ERR_success)
+            dest = e->inode;
+
+        return true;
+    }
+
+    void insert(const inode_t &parent, StringView name, errno_t err, const inode_t &inode) {
+
+        if (err != ERR_success && err != ERR_not_exists)
+            return;
+
+        dentry_t *e = find_entry(parent, name);
+
+        if (!e) {
+            // Replace the least recently used entry.
+            auto &set = set_of(parent, name);
+            e = &set[0];
+            for (dentry_t &x : set) {
+                if (!x.fs) { e = &x; break; }
+                if (x.used < e->used)
+                    e = &x;
+            }
+        }
+
+        e->fs     = parent.fs;
+        e->parent = parent.i;
+        e->name   = name;
+        e->err    = err;
+        e->inode  = err == ERR_success ? inode : inode_t {};
+        e->used   = ++clock;
+    }
+
+    void invalidate(const inode_t &parent, StringView name) {
+        if (dentry_t *e = find_entry(parent, name))
+            *e = dentry_t {};
+    }
+
+    void invalidate_all() {
+        for (auto &set : sets) {
+            for (dentry_t &e : set)
+                e = dentry_t {};
+        }
+    }
+}
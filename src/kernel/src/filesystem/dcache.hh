@@ -0,0 +1,51 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include "types.hh"
+
+/**
+ * Directory entry cache.
+ *
+ * Caches the results of Fs::lookup(), keyed on (parent directory, name), so
+ * that repeatedly resolving the same paths does not require scanning
+ * directories on disk. Lookups of names that do not exist are cached too
+ * (negative entries).
+ *
+ * Only filesystems that allow it (Fs::cache_lookups()) are cached.
+ *
+ * The cache is protected by the VFS lock: Lookups and insertions happen with
+ * the lock held at least shared, invalidations with the lock held exclusively.
+ */
+namespace Vfs::Dcache {
+
+    /**
+     * Look up a name in a directory.
+     *
+     * \return true on a cache hit. `err` is then set to ERR_success (and
+     *         `dest` to the found inode), or to ERR_not_exists.
+     */
+    bool find(const inode_t &parent, StringView name, inode_t &dest, errno_t &err);
+
+    /// Cache the result of a lookup (only ERR_success and ERR_not_exists are cached).
+    void insert(const inode_t &parent, StringView name, errno_t err, const inode_t &inode);
+
+    /// Forget a directory entry (when it is created or removed).
+    void invalidate(const inode_t &parent, StringView name);
+
+    /// Forget everything (e.g. when directories are moved or removed).
+    void invalidate_all();
+}
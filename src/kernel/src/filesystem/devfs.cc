@@ -50,14 +50,14 @@ errno_t DevFs::lookup(inode_t &inode, StringView name, inode_t &dest) {
     return ERR_success;
 }
 
-ssize_t DevFs::read_dir(inode_t &inode, u64 &pos, dir_entry_t &dest) {
+ssize_t DevFs::read_dir(inode_t &inode, dir_pos_t &pos, dir_entry_t &dest) {
 
     if (inode.i == 0) {
         // This is the devfs root dir.
         size_t device_exist_i = 0;
         for (auto [i, device] : enumerate(devices)) {
             if (device) {
-                if (device_exist_i == pos) {
+                if (device_exist_i == pos.i) {
                     dest.name       = device->name;
                     dest.inode      = inode_t {};
                     dest.inode.i    = i;
@@ -66,7 +66,7 @@ ssize_t DevFs::read_dir(inode_t &inode, u64 &pos, dir_entry_t &dest) {
                     dest.inode.size = device->dev.size();
                     dest.inode.fs   = this;
 
-                    ++pos;
+                    ++pos.i;
 
                     return 1;
                 }
@@ -94,6 +94,13 @@ ssize_t DevFs::write(inode_t &inode, u64 offset, const void *buffer, size_t nbyt
     return devices[inode.i]->dev.write(offset, buffer, nbytes);
 }
 
+poll_events_t DevFs::poll(inode_t &inode, Poll::waitq_t *&queue) {
+    assert(inode.i < max_devices, "invalid devfs inode");
+    assert(devices[inode.i],      "invalid devfs inode");
+
+    return devices[inode.i]->dev.poll(queue);
+}
+
 errno_t DevFs::register_device(StringView name, device_t &dev, perm_t perm) {
 
     int device_i = ERR_limit;
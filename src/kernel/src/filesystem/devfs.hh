@@ -33,6 +33,12 @@ public:
         virtual ssize_t read (u64 offset,       void *buffer, size_t nbytes) = 0;
         virtual ssize_t write(u64 offset, const void *buffer, size_t nbytes) = 0;
         virtual s64     size() = 0;
+
+        /// Readiness for poll(), see FileSystem::Fs::poll().
+        virtual poll_events_t poll(Poll::waitq_t *&queue) {
+            queue = nullptr;
+            return poll_in | poll_out;
+        }
     };
 
     struct partition_device_t : public device_t {
@@ -158,9 +164,10 @@ private:
 public:
     errno_t get_root_node(inode_t &node) override;
     errno_t lookup  (inode_t &inode, StringView name, inode_t &dest)                override;
-    ssize_t read_dir(inode_t &inode, u64 &i, dir_entry_t &dest)                     override;
+    ssize_t read_dir(inode_t &inode, dir_pos_t &pos, dir_entry_t &dest)             override;
     ssize_t read    (inode_t &inode, u64 offset,       void *buffer, size_t nbytes) override;
     ssize_t write   (inode_t &inode, u64 offset, const void *buffer, size_t nbytes) override;
+    poll_events_t poll(inode_t &inode, Poll::waitq_t *&queue)                       override;
 
     errno_t register_device(StringView name, device_t &dev, perm_t perm);
 
@@ -14,9 +14,52 @@
  */
 #include "fat32.hh"
 #include "vfs.hh"
+#include "process/proc.hh"
+
+#include "driver/timer/pit.hh"
 
 // This filesystem implementation is currently read-only.
 
+/// Write-back tuning, adjustable via /dev/fat32-writeback ("<expire ms> <dirty %>").
+static u32 writeback_expire_ms = 3000; ///< Dirty blocks are written back after this time.
+static u32 writeback_ratio     = 25;   ///< All dirty blocks are written back once this percentage of a cache is dirty.
+
+/// How often the flusher looks for expired blocks.
+static constexpr s32 writeback_interval_ms = 500;
+
+/// Device /dev/fat32-writeback.
+static struct writeback_device_t : public DevFs::line_device_t<32> {
+    errno_t get(String<32> &str) override {
+        str = "";
+        fmt(str, "{} {}\n", writeback_expire_ms, writeback_ratio);
+        return ERR_success;
+    }
+    errno_t set(StringView v) override {
+        String<32> expire_s = "";
+        String<32>  ratio_s = "";
+        bool have_expire = false;
+        for (char c : v) {
+            if (have_expire)
+                 ratio_s += c;
+            else if (c == ' ')
+                 have_expire = true;
+            else expire_s += c;
+        }
+
+        u32 expire, ratio;
+
+        if (!string_to_num(expire_s, expire)
+         || !string_to_num(ratio_s,  ratio)
+         || ratio < 1 || ratio > 100)
+            return ERR_invalid;
+
+        writeback_expire_ms = expire;
+        writeback_ratio     = ratio;
+
+        return ERR_success;
+    }
+} writeback_device;
+
 Fat32::cache_entry_t &Fat32::get_cache_entry(Fat32::cache_t &c, u32 lba) {
 
     // kprint("{} CACHE {}?\n", &c == &fat_cache ? "FAT" : "DATA", lba);
@@ -37,44 +80,138 @@ Fat32::cache_entry_t &Fat32::get_cache_entry(Fat32::cache_t &c, u32 lba) {
     return c.entries[lru_i];
 }
 
-errno_t Fat32::read_block (u32 lba, Array<u8, block_size> &buffer) {
+errno_t Fat32::read_block(u32 lba, Array<u8, block_size> &buffer) {
     if (lba < block_count)
          // (throw away 'bytes read' information. will become 0 on success)
          return min(0, dev.read(lba*block_size, buffer.data(), block_size));
     else return ERR_io;
 }
 
-// XXX: Writes do not respect the cache currently.
-errno_t Fat32::write_block(u32 lba, const Array<u8, block_size> &buffer) {
-    if (lba < block_count)
-         // (throw away 'bytes written' information. will become 0 on success)
-         return min(0, dev.write(lba*block_size, buffer.data(), block_size));
-    else return ERR_io;
+errno_t Fat32::read_data_block(u32 block_i, block_t &buffer) {
+    return read_block(data_lba + block_i, buffer);
+}
+
+errno_t Fat32::read_fat_block(u32 block_i, fat_block_t &buffer) {
+    return read_block(fat_lba + block_i, *(block_t*)&buffer); // eww.
 }
 
+void Fat32::mark_dirty(cache_t &c, cache_entry_t &e) {
 
-errno_t Fat32::read_data_block (u32 block_i, block_t &buffer) {
-    return read_block(data_lba + block_i, buffer);
+    if (e.dirty) return;
+
+    e.dirty   = true;
+    e.dirtied = Driver::Timer::Pit::ticks();
+
+    // Start writing back early if the cache fills up with dirty blocks, so
+    // that writers rarely need to wait for evictions.
+    if (++c.dirty_count * 100 >= cache_size * writeback_ratio)
+        Poll::notify(flusher_wakeup);
+}
+
+errno_t Fat32::write_back(cache_t &c, u64 dirtied_before) {
+
+    if (!c.dirty_count) return ERR_success;
+
+    // Sort the dirty entries by LBA, so that consecutive blocks can be
+    // written with a single device write.
+    size_t count = 0;
+    for (cache_entry_t &e : c.entries) {
+        if (!e.dirty) continue;
+
+        size_t i = count++;
+        for (; i > 0 && dirty_list[i-1]->lba > e.lba; --i)
+            dirty_list[i] = dirty_list[i-1];
+        dirty_list[i] = &e;
+    }
+
+    for (size_t i = 0; i < count; ) {
+
+        // Find a run of consecutive blocks.
+        size_t n       = 1;
+        bool   expired = dirty_list[i]->dirtied < dirtied_before;
+
+        while (i + n < count
+            && n < max_write_blocks
+            && dirty_list[i+n]->lba == dirty_list[i]->lba + n) {
+            expired |= dirty_list[i+n]->dirtied < dirtied_before;
+            ++n;
+        }
+
+        // Runs are written as a whole as soon as any of their blocks expires.
+        if (expired) {
+            for (size_t j : range(n))
+                memcpy(write_buffer.data() + j*block_size, dirty_list[i+j]->data.data(), block_size);
+
+            u32     lba = dirty_list[i]->lba;
+            ssize_t res = lba + n <= block_count
+                        ? dev.write(u64(lba) * block_size, write_buffer.data(), n * block_size)
+                        : ERR_io;
+            if (res < 0) return res;
+
+            for (size_t j : range(n))
+                dirty_list[i+j]->dirty = false;
+
+            c.dirty_count -= n;
+        }
+
+        i += n;
+    }
+
+    return ERR_success;
 }
-errno_t Fat32::write_data_block(u32 block_i, const block_t &buffer) {
-    return write_block(data_lba + block_i, buffer);
+
+errno_t Fat32::flush(u64 dirtied_before) {
+
+    locked_within_scope _(cache_lock);
+
+    // Data first: The FAT should not refer to clusters with outdated contents.
+    errno_t err = write_back(data_cache, dirtied_before);
+    if (err < 0) return err;
+
+    return write_back(fat_cache, dirtied_before);
 }
 
-errno_t Fat32::read_fat_block (u32 block_i, fat_block_t &buffer) {
-    return read_block(fat_lba + block_i, *(block_t*)&buffer); // eww.
+errno_t Fat32::sync() {
+    return flush(intmax<u64>::value);
 }
-errno_t Fat32::write_fat_block(u32 block_i, const fat_block_t &buffer) {
-    return write_block(fat_lba + block_i, *(block_t*)&buffer); // eww.
+
+void Fat32::flusher(int arg) {
+
+    Fat32 &fs = *(Fat32*)arg;
+
+    while (true) {
+        Poll::sleep(fs.flusher_wakeup, writeback_interval_ms);
+
+        u64 now = Driver::Timer::Pit::ticks();
+
+        bool crowded = (fs.data_cache.dirty_count * 100 >= cache_size * writeback_ratio)
+                    || (fs. fat_cache.dirty_count * 100 >= cache_size * writeback_ratio);
+
+        errno_t err = fs.flush(crowded                          ? intmax<u64>::value
+                              :now > writeback_expire_ms        ? now - writeback_expire_ms
+                              :                                   0);
+        if (err < 0)
+            kprint("fat32: write-back to {} failed: {}\n", fs.name_, error_name(err));
+    }
 }
 
-errno_t Fat32::get_fat_block(u32 block_i, fat_block_t *&block) {
+errno_t Fat32::get_fat_block(u32 block_i, fat_block_t *&block, cache_entry_t **entry) {
+
+    locked_within_scope _(cache_lock);
 
     u32 lba = fat_lba + block_i;
     cache_entry_t &e = get_cache_entry(fat_cache, lba);
 
     block = &e.fat;
+    if (entry) *entry = &e;
 
     if (e.lba != lba) {
+        if (e.dirty) {
+            // Evicting a dirty block: Write back everything, as long as we're at it.
+            errno_t err = write_back(fat_cache, intmax<u64>::value);
+            if (err) return err;
+        }
+
         e.lba = intmax<u32>::value;
         errno_t err = read_fat_block(block_i, e.fat);
         if (err) return err;
@@ -84,14 +221,23 @@ errno_t Fat32::get_fat_block(u32 block_i, fat_block_t *&block) {
     return ERR_success;
 }
 
-errno_t Fat32::get_data_block(u32 block_i, block_t *&block) {
+errno_t Fat32::get_data_block(u32 block_i, block_t *&block, cache_entry_t **entry) {
+
+    locked_within_scope _(cache_lock);
 
     u32 lba = data_lba + block_i;
     cache_entry_t &e = get_cache_entry(data_cache, lba);
 
     block = &e.data;
+    if (entry) *entry = &e;
 
     if (e.lba != lba) {
+        if (e.dirty) {
+            // Evicting a dirty block: Write back everything, as long as we're at it.
+            errno_t err = write_back(data_cache, intmax<u64>::value);
+            if (err) return err;
+        }
+
         e.lba = intmax<u32>::value;
         errno_t err = read_data_block(block_i, e.data);
         if (err) return err;
@@ -107,7 +253,8 @@ static constexpr bool is_eoc(u32 cluster_n) {
 
 errno_t Fat32::get_next_cluster_n(u32 cluster_n, u32 &next, u32 inc) {
 
-    locked_within_scope _(fat_lock);
+    // Chain walks by different readers may proceed in parallel.
+    read_locked_within_scope _(fat_lock);
 
     next = cluster_n;
 
@@ -120,20 +267,26 @@ errno_t Fat32::get_next_cluster_n(u32 cluster_n, u32 &next, u32 inc) {
         if (err < 0) return err;
 
         next = (*fat)[next % fat->size()];
+
+        // Long cluster chains may take a while to walk.
+        Process::preempt_point();
     }
     return ERR_success;
 }
 
 errno_t Fat32::set_next_cluster_n(u32 cluster_n, u32 next) {
 
-    locked_within_scope _(fat_lock);
+    write_locked_within_scope _(fat_lock);
 
-    fat_block_t *fat = nullptr;
-    errno_t err = get_fat_block(cluster_n / fat->size(), fat);
+    fat_block_t   *fat   = nullptr;
+    cache_entry_t *entry = nullptr;
+    errno_t err = get_fat_block(cluster_n / fat->size(), fat, &entry);
     if (err < 0) return err;
 
     (*fat)[cluster_n % fat->size()] = next;
-    return write_fat_block(cluster_n / fat->size(), *fat);
+    mark_dirty(fat_cache, *entry);
+
+    return ERR_success;
 }
 
 errno_t Fat32::allocate_cluster(u32 cluster, u32 &next) {
@@ -267,15 +420,30 @@ errno_t Fat32::get_root_node(inode_t &inode) {
     return ERR_success;
 }
 
-ssize_t Fat32::read_dir(inode_t &inode, u64 &i, dir_entry_t &dest) {
+ssize_t Fat32::read_dir(inode_t &inode, dir_pos_t &pos, dir_entry_t &dest) {
 
-    bool found = false;
+    static constexpr u32 dirents_per_block = block_size / sizeof(fat_dir_entry_t);
+
+    u64 &i = pos.i;
     errno_t err;
 
-    // Iterate over clusters.
-    while (true) {
-        u32 dir_cluster_i = i * sizeof(fat_dir_entry_t) / block_size / cluster_size;
-        u32 cluster = inode.i;
+    // pos.hint, if set, is the cluster that holds the entry before i (the
+    // last one returned). This saves a walk from the start of the cluster
+    // chain on every call, which would make listing a directory quadratic.
+    u32 cluster;
+    u32 dirents_per_cluster = dirents_per_block * cluster_size;
+
+    if (pos.hint && i) {
+        cluster = pos.hint;
+        if (i % dirents_per_cluster == 0) {
+            err = get_next_cluster_n(cluster, cluster);
+            if (is_eoc(cluster))       return 0;
+            if (err == ERR_not_exists) return 0;
+            if (err)                   return err;
+        }
+    } else {
+        cluster = inode.i;
+        u32 dir_cluster_i = i / dirents_per_cluster;
 
         if (dir_cluster_i != 0) {
             err = get_next_cluster_n(inode.i, cluster, dir_cluster_i);
@@ -285,10 +453,14 @@ ssize_t Fat32::read_dir(inode_t &inode, u64 &i, dir_entry_t &dest) {
             if (err == ERR_not_exists) return 0;
             if (err)                   return err;
         }
+    }
+
+    // Iterate over clusters.
+    while (true) {
 
         // Iterate over blocks.
 
-        for (u32 block_i = i * sizeof(fat_dir_entry_t) / block_size % cluster_size
+        for (u32 block_i = i / dirents_per_block % cluster_size
             ;block_i < cluster_size
             ;++block_i) {
 
@@ -300,10 +472,10 @@ ssize_t Fat32::read_dir(inode_t &inode, u64 &i, dir_entry_t &dest) {
             // hex_dump(block->data(), 512);
 
             const auto &dirents
-                = *(Array<fat_dir_entry_t, block_size / sizeof(fat_dir_entry_t)>*) block;
+                = *(Array<fat_dir_entry_t, dirents_per_block>*) block;
 
             // Iterate over dirents.
-            for (u32 entry_i : range(i % (block_size / sizeof(fat_dir_entry_t)), dirents.size())) {
+            for (u32 entry_i : range(i % dirents_per_block, dirents.size())) {
 
                 const fat_dir_entry_t &entry = dirents[entry_i];
 
@@ -347,18 +519,26 @@ ssize_t Fat32::read_dir(inode_t &inode, u64 &i, dir_entry_t &dest) {
                         inode_parent_dirent_i(dest.inode) = i;
 
                         ++i;
-                        // kprint("OK????? i -> {}\n", i);
+                        pos.hint = cluster;
 
                         return 1;
                     }
                 }
 
+                // Skipped entries move the position too: Keep the hint in
+                // step, in case we cross into the next cluster before
+                // returning.
                 ++i;
+                pos.hint = cluster;
             }
         }
-    }
 
-    return 0;
+        // Continue in the next cluster.
+        err = get_next_cluster_n(cluster, cluster);
+        if (is_eoc(cluster))       return 0;
+        if (err == ERR_not_exists) return 0;
+        if (err)                   return err;
+    }
 }
 
 ssize_t Fat32::read(inode_t &inode, u64 offset, void *buffer, size_t nbytes) {
@@ -397,6 +577,47 @@ ssize_t Fat32::read(inode_t &inode, u64 offset, void *buffer, size_t nbytes) {
             // kprint("READ BLOCK {}:{} OF FILE (INODE {}) CSZ {}\n"
             //       , cluster_i, block_i, inode.i, cluster_size);
 
+            u64 remaining = min(u64(nbytes) - bytes_read
+                               ,inode.size - (offset + bytes_read));
+
+            if ((offset + bytes_read) % block_size == 0 && remaining >= block_size) {
+                // Whole blocks are read straight into the buffer, as many
+                // as possible at once: A multi-block read is much faster
+                // than fetching the blocks one by one.
+                u32 count = min(u64(cluster_size - block_i), remaining / block_size);
+                u32 lba   = data_lba + (cluster_i-2) * cluster_size + block_i;
+
+                if (lba + count > block_count) return ERR_io;
+
+                {
+                    // Cached blocks may be newer than what is on disk (see
+                    // write_back), so they are copied over what we read.
+                    // The cache must not change in between: A block that is
+                    // dirtied and then written back and evicted while the
+                    // device read blocks would otherwise be missed.
+                    locked_within_scope _(cache_lock);
+
+                    ssize_t res = dev.read(u64(lba) * block_size
+                                          ,(u8*)buffer + bytes_read
+                                          ,count * block_size);
+                    if (res < 0) return res;
+
+                    for (cache_entry_t &e : data_cache.entries) {
+                        if (e.lba >= lba && e.lba < lba + count)
+                            memcpy((u8*)buffer + bytes_read + (e.lba - lba) * block_size
+                                  ,e.data.data()
+                                  ,block_size);
+                    }
+                }
+
+                bytes_read += count * block_size;
+                block_i    += count - 1;
+                continue;
+            }
+
+            if (remaining == 0)
+                return bytes_read;
+
             block_t *block;
             err = get_data_block((cluster_i-2) * cluster_size + block_i, block);
             // kprint("block {} -> {}\n", cluster_i * cluster_size + block_i, error_name(err));
@@ -412,6 +633,8 @@ ssize_t Fat32::read(inode_t &inode, u64 offset, void *buffer, size_t nbytes) {
 
             bytes_read += to_copy;
         }
+
+        Process::preempt_point();
     }
 
     return bytes_read;
@@ -433,7 +656,7 @@ ssize_t Fat32::write(inode_t &inode, u64 offset, const void *buffer, size_t nbyt
             return ERR_nospace; // XXX
             // return bytes_written;
 
-        u32 file_cluster_i = offset / block_size / cluster_size;
+        u32 file_cluster_i = (offset + bytes_written) / block_size / cluster_size;
         u32 cluster_i      = inode.i;
 
         if (file_cluster_i != 0) {
@@ -453,8 +676,13 @@ ssize_t Fat32::write(inode_t &inode, u64 offset, const void *buffer, size_t nbyt
             ;block_i < cluster_size
             ;++block_i) {
 
-            block_t *block;
-            err = get_data_block((cluster_i-2) * cluster_size + block_i, block);
+            if (bytes_written == nbytes
+             || offset + bytes_written >= inode.size)
+                break;
+
+            block_t       *block;
+            cache_entry_t *entry;
+            err = get_data_block((cluster_i-2) * cluster_size + block_i, block, &entry);
             // kprint("block {} -> {}\n", cluster_i * cluster_size + block_i, error_name(err));
             if (err) return err;
 
@@ -466,10 +694,13 @@ ssize_t Fat32::write(inode_t &inode, u64 offset, const void *buffer, size_t nbyt
                   ,((u8*)buffer)+bytes_written
                   ,to_copy);
 
-            err = write_data_block((cluster_i-2) * cluster_size + block_i, *block);
+            // The block is written to disk later on (see write_back).
+            mark_dirty(data_cache, *entry);
 
             bytes_written += to_copy;
         }
+
+        Process::preempt_point();
     }
 
     return bytes_written;
@@ -545,11 +776,19 @@ Fat32 *Fat32::try_mount(DevFs::device_t &dev, StringView devname) {
     // kprint("fat volume name: {}\n", StringView(br.ebpb.volume_label.data()
     //                                           ,br.ebpb.volume_label.size()));
 
-    if (Vfs::mount(*fs, devname) == ERR_success)
-         return fs;
-    else return nullptr;
+    if (Vfs::mount(*fs, devname) != ERR_success)
+        return nullptr;
+
+    static bool have_writeback_device = false;
+    if (!have_writeback_device) {
+        DevFs *devfs = Vfs::get_devfs();
+        if (devfs) devfs->register_device("fat32-writeback", writeback_device, 0644);
+        have_writeback_device = true;
+    }
+
+    Process::make_kernel_thread(flusher, "fat32-flush", (int)fs);
 
-    return nullptr;
+    return fs;
 }
 
 Fat32::Fat32(DevFs::device_t &d
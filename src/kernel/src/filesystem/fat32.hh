@@ -17,6 +17,8 @@
 #include "common.hh"
 #include "filesystem.hh"
 #include "devfs.hh"
+#include "ipc/rwlock.hh"
+#include "ipc/poll.hh"
 
 // TODO: -> into FileSystem namespace. Same with devfs.
 
@@ -46,20 +48,49 @@ class Fat32 : public FileSystem::Fs {
 
         u32 lba = intmax<u32>::value;
         u32 hit = 0;
+
+        bool dirty   = false; ///< Modified, but not yet written to disk.
+        u64  dirtied = 0;     ///< When the entry became dirty (in timer ticks).
     };
 
     struct cache_t {
         Array<cache_entry_t, cache_size> entries;
 
-        u32 last_hit = 0;
+        u32    last_hit    = 0;
+        size_t dirty_count = 0;
     };
 
     cache_t  fat_cache;
     cache_t data_cache;
 
+    /// Protects the caches. Held while blocks are read in or written back,
+    /// and while read() reads around the cache.
+    mutex_t cache_lock;
+
     cache_entry_t &get_cache_entry(cache_t &c, u32 lba);
 
-    mutex_t fat_lock;
+    // Write-back.
+    // Modified blocks are only marked dirty, and are written to disk later
+    // on by a flusher thread (or when they need to be evicted), with as many
+    // consecutive blocks as possible per device write.
+
+    /// Blocks per device write.
+    static constexpr size_t max_write_blocks = 64;
+
+    Array<cache_entry_t*, cache_size>               dirty_list;   ///< (used by write_back)
+    Array<u8,             max_write_blocks*block_size> write_buffer; ///< (used by write_back)
+
+    /// The flusher sleeps here, writers wake it up when many blocks are dirty.
+    Poll::waitq_t flusher_wakeup;
+
+    void    mark_dirty(cache_t &c, cache_entry_t &e);
+    errno_t write_back(cache_t &c, u64 dirtied_before); ///< Requires cache_lock.
+    errno_t flush(u64 dirtied_before);
+
+    static void flusher(int arg);
+
+    /// Protects the FAT: Lookups are shared, cluster chain updates exclusive.
+    rwlock_t fat_lock;
 
     // Cached filesystem data.
     u32 block_count   = 0;
@@ -70,29 +101,28 @@ class Fat32 : public FileSystem::Fs {
     u32 root_cluster  = 0;
     u32 cluster_count = 0;
 
-    errno_t read_block (u32 lba,       block_t &buffer);
-    errno_t write_block(u32 lba, const block_t &buffer);
-
-    errno_t read_data_block (u32 block_i,       block_t &buffer);
-    errno_t write_data_block(u32 block_i, const block_t &buffer);
-
-    errno_t read_fat_block (u32 block_i,       fat_block_t &buffer);
-    errno_t write_fat_block(u32 block_i, const fat_block_t &buffer);
+    errno_t read_block     (u32 lba,     block_t     &buffer);
+    errno_t read_data_block(u32 block_i, block_t     &buffer);
+    errno_t read_fat_block (u32 block_i, fat_block_t &buffer);
 
     errno_t get_next_cluster_n(u32 cluster_n, u32 &next, u32 inc = 1);
     errno_t set_next_cluster_n(u32 cluster_n, u32  next);
 
     errno_t allocate_cluster(u32 cluster, u32 &next);
 
-    errno_t get_fat_block(u32 block_i, fat_block_t *&block);
-    errno_t get_data_block(u32 block_i, block_t *&block);
+    // The entry is returned as well if requested, for use with mark_dirty().
+    errno_t get_fat_block (u32 block_i, fat_block_t *&block, cache_entry_t **entry = nullptr);
+    errno_t get_data_block(u32 block_i, block_t     *&block, cache_entry_t **entry = nullptr);
 
 public:
     const file_name_t &type() const override { return type_; }
     const file_name_t &name() const override { return name_; }
 
     errno_t get_root_node(inode_t &inode) override;
-    ssize_t read_dir(inode_t &inode, u64 &i, dir_entry_t &dest) override;
+    errno_t sync()                        override;
+    bool    cache_lookups() const         override { return true; }
+    bool    cache_pages(const inode_t &) const override { return true; }
+    ssize_t read_dir(inode_t &inode, dir_pos_t &pos, dir_entry_t &dest) override;
 
     // errno_t lookup(inode_t &inode, StringView name, inode_t &dest);
     ssize_t read  (inode_t &inode, u64 offset,       void *buffer, size_t nbytes) override;
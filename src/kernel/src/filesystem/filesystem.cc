@@ -22,9 +22,9 @@ namespace FileSystem {
 
         dir_entry_t entry;
 
-        u64 i = 0;
+        dir_pos_t pos;
         while (true) {
-            errno_t err = read_dir(inode, i, entry);
+            errno_t err = read_dir(inode, pos, entry);
             if (err > 0) {
                 if (entry.name == name) {
                     dest = entry.inode;
@@ -63,6 +63,13 @@ namespace FileSystem {
         return ERR_success;
     }
 
+    errno_t Fs::sync() { return ERR_success; }
+
+    poll_events_t Fs::poll(inode_t&, Poll::waitq_t *&queue) {
+        queue = nullptr;
+        return poll_in | poll_out;
+    }
+
     errno_t Fs::mkdir (inode_t&, StringView)                       { return ERR_not_supported; }
     errno_t Fs::rmdir (inode_t&, StringView)                       { return ERR_not_supported; }
     errno_t Fs::rename(inode_t&, StringView, inode_t&, StringView) { return ERR_not_supported; }
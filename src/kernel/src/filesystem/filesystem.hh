@@ -16,6 +16,7 @@
 
 #include "common.hh"
 #include "types.hh"
+#include "ipc/poll.hh"
 
 namespace FileSystem {
 
@@ -33,11 +34,12 @@ namespace FileSystem {
         // Minimum required features.
         virtual errno_t get_root_node(inode_t &inode) = 0;
 
-        // i is an implementation-defined index number. i 0 must always return
-        // the first directory entry, if any.
+        // pos.i is an implementation-defined index number. i 0 must always
+        // return the first directory entry, if any.
         // The function will increment i in an implementation-defined manner
-        // that ensures all entries are returned exactly once.
-        virtual ssize_t read_dir(inode_t &inode, u64 &i, dir_entry_t &dest) = 0;
+        // that ensures all entries are returned exactly once, and may update
+        // pos.hint to speed up the next call.
+        virtual ssize_t read_dir(inode_t &inode, dir_pos_t &pos, dir_entry_t &dest) = 0;
 
         // Optional features.
 
@@ -52,6 +54,26 @@ namespace FileSystem {
 
         virtual errno_t seek(inode_t &inode, u64 &pos, seek_t dir, s64 offset);
 
+        // Write all modified data that is cached by the filesystem to disk.
+        // (filesystems need not keep track of modifications per file, so
+        //  this is used for fsync() as well)
+        virtual errno_t sync();
+
+        // Whether the VFS may cache lookup results (see Vfs::Dcache).
+        // Filesystems whose metadata can change without going through
+        // the VFS (such as device sizes) must not allow this.
+        virtual bool cache_lookups() const { return false; }
+
+        // Whether the VFS may cache the data of a file (see Vfs::PageCache).
+        // This requires that the file only changes through the VFS, and
+        // that reads only return less than requested at the end of the file.
+        virtual bool cache_pages(const inode_t &) const { return false; }
+
+        // Readiness of a file for poll(). If reading or writing may block,
+        // `queue` is set to a wait queue that is notified on changes.
+        // By default, files never block.
+        virtual poll_events_t poll(inode_t &inode, Poll::waitq_t *&queue);
+
         virtual errno_t mkdir (inode_t &inode, StringView name);
         virtual errno_t rmdir (inode_t &inode, StringView name);
         virtual errno_t rename(inode_t &src_inode, StringView src_name
@@ -0,0 +1,378 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "page-cache.hh"
+#include "filesystem.hh"
+#include "ipc/semaphore.hh"
+#include "memory/kernel-heap.hh"
+#include "memory/manager-physical.hh"
+#include "process/proc.hh"
+
+namespace Vfs::PageCache {
+
+    struct page_t {
+        // Key.
+        FileSystem::Fs *fs = nullptr; ///< nullptr if this page is unused.
+        u64 i        = 0;
+        u64 context1 = 0;             ///< (see inode_t)
+        u64 context2 = 0;
+        u64 index    = 0;             ///< Page number within the file.
+
+        u32  valid      = 0;          ///< Amount of bytes of file data in this page.
+        bool referenced = false;      ///< For CLOCK replacement.
+        bool busy       = false;      ///< Being filled by a filesystem read.
+        bool discard    = false;      ///< Invalidated while busy.
+
+        page_t *next = nullptr;       ///< Next page in the same bucket.
+    };
+
+    /// Upper limits for the cache size, whatever the amount of free memory.
+    static constexpr size_t max_pages = 64_MiB / page_size;
+    static constexpr size_t min_pages = 16;
+
+    /// The cache only grows while more than this amount of physical pages is free.
+    static constexpr size_t reserved_pages = 4_MiB / page_size;
+
+    static constexpr size_t bucket_count = 1024; ///< (must be a power of two)
+
+    static Array<page_t*, bucket_count> buckets;
+
+    // Page data lives in one large heap allocation: Heap memory is only
+    // backed by physical memory once it is used, so this costs nothing
+    // until the cache actually grows.
+    static page_t *pages      = nullptr;
+    static u8     *page_data  = nullptr;
+    static size_t  page_count = 0; ///< Size of the pool.
+    static size_t  pages_used = 0; ///< Amount of pages that were ever handed out.
+    static size_t  hand       = 0; ///< CLOCK hand.
+
+    /// Signalled whenever a page fill completes.
+    static semaphore_t fill_done { 0, {} };
+
+    /// A request to read part of a file into the cache in the background.
+    struct readahead_t {
+        inode_t inode;
+        u64     first = 0; ///< Page numbers (inclusive).
+        u64     last  = 0;
+    };
+
+    static constexpr size_t readahead_queue_size = 16;
+
+    static Array<readahead_t, readahead_queue_size> readahead_queue;
+    static size_t readahead_head = 0;
+    static size_t readahead_tail = 0;
+
+    /// Counts queued readahead requests. The readahead worker sleeps here.
+    static semaphore_t readahead_work { 0, {} };
+
+    static u64 hits       = 0;
+    static u64 misses     = 0;
+    static u64 prefetched = 0;
+
+    static u8 *data_of(const page_t *page) {
+        return page_data + (page - pages) * page_size;
+    }
+
+    static page_t *&bucket(const inode_t &inode, u64 index) {
+        u32 h = (u32)inode.i        * 2654435761u
+              ^ (u32)inode.context1 * 40503u
+              ^ (u32)inode.context2
+              ^ (u32)(addr_t)inode.fs
+              ^ (u32)index          * 16777619u;
+        return buckets[h & (bucket_count - 1)];
+    }
+
+    static bool matches(const page_t &page, const inode_t &inode, u64 index) {
+        return page.fs       == inode.fs
+            && page.i        == inode.i
+            && page.context1 == inode.context1
+            && page.context2 == inode.context2
+            && page.index    == index;
+    }
+
+    static page_t *find(const inode_t &inode, u64 index) {
+        for (page_t *p = bucket(inode, index); p; p = p->next) {
+            if (matches(*p, inode, index))
+                return p;
+        }
+        return nullptr;
+    }
+
+    /// Remove a page from its bucket, and mark it unused.
+    static void remove(page_t *page) {
+        inode_t inode;
+        inode.fs       = page->fs;
+        inode.i        = page->i;
+        inode.context1 = page->context1;
+        inode.context2 = page->context2;
+
+        for (page_t **p = &bucket(inode, page->index); *p; p = &(*p)->next) {
+            if (*p == page) {
+                *p = page->next;
+                break;
+            }
+        }
+        *page = page_t {};
+    }
+
+    /// Get an unused page, either by growing the cache or by evicting one.
+    static page_t *alloc_page() {
+
+        if (pages_used < page_count
+         && Memory::Physical::total_pages_free() > reserved_pages)
+            return &pages[pages_used++];
+
+        // CLOCK: Evict the first page that was not referenced since the
+        // hand last passed it. Two rounds are always enough, unless all
+        // pages are busy.
+        for (size_t n = 0; n < 2 * pages_used; ++n) {
+            page_t *page = &pages[hand];
+            hand = (hand + 1) % pages_used;
+
+            if (page->busy) continue;
+
+            if (page->referenced) {
+                page->referenced = false;
+                continue;
+            }
+            if (page->fs)
+                remove(page);
+
+            return page;
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * Read a page that is not in the cache from the filesystem.
+     *
+     * \return ERR_again if the page was invalidated while it was being read,
+     *         ERR_nomem if no page could be made available.
+     */
+    static errno_t fill_page(inode_t &inode, u64 index, page_t *&dest) {
+
+        page_t *page = alloc_page();
+        if (!page) return ERR_nomem;
+
+        page->fs       = inode.fs;
+        page->i        = inode.i;
+        page->context1 = inode.context1;
+        page->context2 = inode.context2;
+        page->index    = index;
+        page->busy     = true;
+
+        page_t *&head = bucket(inode, index);
+        page->next = head;
+        head       = page;
+
+        // This may block: The page stays busy (and will not be evicted) until we're done.
+        ssize_t res = inode.fs->read(inode, index * page_size, data_of(page), page_size);
+
+        page->busy = false;
+        signal_all(fill_done);
+
+        if (res < 0 || page->discard) {
+            // (if the file was written to while we were reading it, the
+            //  data may be outdated)
+            bool discarded = res >= 0;
+            remove(page);
+            return discarded ? ERR_again : res;
+        }
+
+        page->valid = res;
+        dest        = page;
+
+        return ERR_success;
+    }
+
+    /**
+     * Find a page in the cache, reading it from the filesystem if needed.
+     *
+     * \return ERR_nomem if no page could be made available, in which case
+     *         the caller should bypass the cache.
+     */
+    static errno_t get_page(inode_t &inode, u64 index, page_t *&dest) {
+
+        while (true) {
+            while (page_t *page = find(inode, index)) {
+                if (!page->busy) {
+                    ++hits;
+                    page->referenced = true;
+                    dest = page;
+                    return ERR_success;
+                }
+
+                // Someone else is reading this page, wait for them and try again.
+                wait(fill_done);
+            }
+
+            ++misses;
+
+            errno_t err = fill_page(inode, index, dest);
+            if (err == ERR_again)
+                continue;
+
+            if (err >= 0)
+                dest->referenced = true;
+
+            return err;
+        }
+    }
+
+    ssize_t read(inode_t &inode, u64 offset, void *buffer, size_t nbytes) {
+
+        size_t done = 0;
+
+        while (done < nbytes) {
+            u64    pos     = offset + done;
+            size_t in_page = pos % page_size;
+
+            page_t *page;
+            errno_t err = get_page(inode, pos / page_size, page);
+
+            if (err == ERR_nomem) {
+                // No room in the cache: Read directly from the filesystem instead.
+                ssize_t res = inode.fs->read(inode, pos, (u8*)buffer + done, nbytes - done);
+                if (res < 0) return done ? done : res;
+                return done + res;
+            }
+            if (err < 0) return done ? done : err;
+
+            if (in_page >= page->valid)
+                break; // End of file.
+
+            size_t to_copy = min(nbytes - done, page->valid - in_page);
+            memcpy((u8*)buffer + done, data_of(page) + in_page, to_copy);
+            done += to_copy;
+
+            if (page->valid < page_size)
+                break; // Short page: End of file.
+
+            Process::preempt_point();
+        }
+
+        return done;
+    }
+
+    void invalidate(const inode_t &inode, u64 offset, u64 nbytes) {
+
+        if (!pages || !nbytes) return;
+
+        u64 first = offset / page_size;
+        u64 last  = (offset + nbytes - 1) / page_size;
+
+        // Large ranges are more quickly handled by walking the whole pool.
+        if (last - first >= pages_used) {
+            for (size_t i : range(pages_used)) {
+                page_t &page = pages[i];
+                if (page.fs && matches(page, inode, page.index)
+                 && page.index >= first && page.index <= last) {
+                    if (page.busy) page.discard = true;
+                    else           remove(&page);
+                }
+            }
+            return;
+        }
+
+        for (u64 index = first; index <= last; ++index) {
+            if (page_t *page = find(inode, index)) {
+                if (page->busy) page->discard = true;
+                else            remove(page);
+            }
+        }
+    }
+
+    void readahead(const inode_t &inode, u64 offset, u64 nbytes) {
+
+        if (!pages || offset >= inode.size) return;
+
+        nbytes = min(nbytes, inode.size - offset);
+        if (!nbytes) return;
+
+        // This is only a hint: Drop it if the worker cannot keep up.
+        if (readahead_tail - readahead_head >= readahead_queue_size)
+            return;
+
+        readahead_t &r = readahead_queue[readahead_tail++ % readahead_queue_size];
+        r.inode = inode;
+        r.first = offset / page_size;
+        r.last  = (offset + nbytes - 1) / page_size;
+
+        signal(readahead_work);
+    }
+
+    static void readahead_worker() {
+        while (true) {
+            wait(readahead_work);
+
+            // Copy the request: Its queue slot may be reused while we block.
+            readahead_t r = readahead_queue[readahead_head++ % readahead_queue_size];
+
+            for (u64 index = r.first; index <= r.last; ++index) {
+                if (find(r.inode, index))
+                    continue;
+
+                page_t *page;
+                errno_t err = fill_page(r.inode, index, page);
+
+                if (err == ERR_again) continue;
+                if (err <  0)         break;
+
+                // Prefetched pages are not referenced until they are read,
+                // so that unused readahead data is evicted first.
+                ++prefetched;
+
+                if (page->valid < page_size)
+                    break; // End of file.
+            }
+        }
+    }
+
+    void dump_stats() {
+        kprint("\npage cache:\n");
+        kprint("  pages: {} used of {} ({S} of {S})\n"
+              ,pages_used, page_count
+              ,pages_used * page_size
+              ,page_count * page_size);
+        kprint("  hits:  {}\n", hits);
+        kprint("  miss:  {}\n", misses);
+        kprint("  ahead: {}\n", prefetched);
+    }
+
+    void init() {
+        // Allow the cache to take up to a quarter of free memory.
+        page_count = clamp(min_pages, max_pages, Memory::Physical::total_pages_free() / 4);
+
+        pages     = (page_t*)Memory::Heap::alloc(page_count * sizeof(page_t), alignof(page_t));
+        page_data = (u8*)    Memory::Heap::alloc(page_count * page_size,      page_size);
+
+        if (!pages || !page_data) {
+            klog("page cache: could not allocate {} pages, caching disabled\n", page_count);
+            if (pages)     Memory::Heap::free(pages);
+            if (page_data) Memory::Heap::free(page_data);
+            pages      = nullptr;
+            page_data  = nullptr;
+            page_count = 0;
+            return;
+        }
+
+        for (size_t i : range(page_count))
+            pages[i] = page_t {};
+
+        klog("page cache: up to {} pages ({S})\n", page_count, page_count * page_size);
+
+        Process::make_kernel_thread(readahead_worker, "readahead");
+    }
+}
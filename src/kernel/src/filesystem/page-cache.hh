@@ -0,0 +1,71 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include "types.hh"
+
+/**
+ * Page cache.
+ *
+ * Caches file data in pages of 4 KiB, keyed on (filesystem, inode, page
+ * index), so that repeated reads of the same data are served from memory
+ * without calling into the filesystem at all.
+ *
+ * Only files that a filesystem allows to be cached are cached (see
+ * Fs::cache_pages()). For those files, a short read from the filesystem must
+ * mean that the end of the file was reached.
+ *
+ * The cache grows as long as enough physical memory is free, up to a limit
+ * that is decided at boot from the amount of free memory. After that, pages
+ * are reused with CLOCK (second chance) replacement.
+ *
+ * The cache does not need a lock of its own: Kernel code only switches
+ * threads when it blocks or calls Process::preempt_point(), and pages that
+ * are being filled by a (blocking) filesystem read are marked busy until the
+ * read completes. Other than that, the cache never holds on to a page_t
+ * across a blocking call or a preempt_point(): The page may be evicted or
+ * invalidated in the meantime.
+ */
+namespace Vfs::PageCache {
+
+    constexpr size_t page_size = 4_KiB;
+
+    /**
+     * Read file data through the cache.
+     *
+     * Behaves exactly like Fs::read(): Pages that are not in the cache are
+     * read from the inode's filesystem and kept for later.
+     */
+    ssize_t read(inode_t &inode, u64 offset, void *buffer, size_t nbytes);
+
+    /**
+     * Read part of a file into the cache in the background.
+     *
+     * This is a hint: Requests may be dropped when the cache is busy.
+     */
+    void readahead(const inode_t &inode, u64 offset, u64 nbytes);
+
+    /// Forget cached data in the given range of a file (e.g. when it is
+    /// written to or truncated).
+    void invalidate(const inode_t &inode, u64 offset, u64 nbytes);
+
+    /// Forget all cached data of a file (e.g. when it is removed).
+    inline void invalidate(const inode_t &inode) { invalidate(inode, 0, inode.size); }
+
+    void dump_stats();
+
+    void init();
+}
@@ -0,0 +1,123 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pipe.hh"
+
+// Note: The kernel is not pre-emptible, so the pipe state can only change
+// while we are blocked.
+
+/// Wake up readers and pollers (there is data, or EOF).
+static void wake_readers(pipe_t &pipe) {
+    signal_all(pipe.readable);
+    Poll::notify(pipe.pollers);
+}
+
+/// Wake up writers and pollers (there is space, or no readers are left).
+static void wake_writers(pipe_t &pipe) {
+    signal_all(pipe.writable);
+    Poll::notify(pipe.pollers);
+}
+
+ssize_t pipe_t::read(void *buffer_, size_t nbytes) {
+
+    u8 *buffer = (u8*)buffer_;
+
+    while (!used()) {
+        if (!has_writers)
+            return 0; // EOF.
+
+        wait(readable);
+    }
+
+    size_t count = min(nbytes, used());
+
+    // Copy in at most two parts (the data may wrap around).
+    size_t start = head % pipe_size;
+    size_t part  = min(count, pipe_size - start);
+
+    memcpy(buffer,        &data[start], part);
+    memcpy(buffer + part, &data[0],     count - part);
+
+    head += count;
+
+    if (free() >= write_wake_threshold)
+        wake_writers(*this);
+
+    return count;
+}
+
+ssize_t pipe_t::write(const void *buffer_, size_t nbytes) {
+
+    const u8 *buffer = (const u8*)buffer_;
+
+    size_t written = 0;
+
+    while (written < nbytes) {
+
+        if (!has_readers)
+            break;
+
+        if (!free()) {
+            // Let readers drain the pipe before we go to sleep.
+            wake_readers(*this);
+            wait(writable);
+            continue;
+        }
+
+        size_t count = min(nbytes - written, free());
+        size_t start = tail % pipe_size;
+        size_t part  = min(count, pipe_size - start);
+
+        memcpy(&data[start], buffer + written,        part);
+        memcpy(&data[0],     buffer + written + part, count - part);
+
+        tail    += count;
+        written += count;
+    }
+
+    if (written)
+        wake_readers(*this);
+    else if (!has_readers)
+        return ERR_io;
+
+    return written;
+}
+
+poll_events_t pipe_t::poll(Poll::waitq_t *&queue) {
+
+    queue = &pollers;
+
+    poll_events_t events = 0;
+
+    // Reads return EOF and writes fail without blocking once the other side is gone.
+    if (used() || !has_writers) events |= poll_in;
+    if (free() || !has_readers) events |= poll_out;
+
+    if (!has_readers || !has_writers)
+        events |= poll_hup;
+
+    return events;
+}
+
+void pipe_t::close_end(bool readers_left, bool writers_left) {
+
+    if (has_readers && !readers_left) {
+        has_readers = false;
+        wake_writers(*this);
+    }
+    if (has_writers && !writers_left) {
+        has_writers = false;
+        wake_readers(*this);
+    }
+}
@@ -16,12 +16,71 @@
 
 #include "common.hh"
 #include "types.hh"
+#include "ipc/poll.hh"
 
+/**
+ * Pipe.
+ *
+ * A pipe is a ring buffer with one or more reading handles and one or more
+ * writing handles. Readers block while the pipe is empty, writers block
+ * while it is full.
+ *
+ * Wakeups are batched: A read or write call wakes up the other side at most
+ * once per call (or once before it blocks), and blocked writers are only
+ * woken once a reasonable amount of space has been freed. This avoids
+ * bouncing between reader and writer for every few bytes transferred.
+ */
 struct pipe_t {
-    file_handle_t *in;
-    file_handle_t *out;
 
-    static constexpr size_t pipe_size = 512;
+    static constexpr size_t pipe_size = 64_KiB;
+
+    /// Blocked writers are woken when at least this much space is free.
+    static constexpr size_t write_wake_threshold = pipe_size / 4;
 
     Array<u8, pipe_size> data;
+
+    /// Read and write positions (free-running, wrapped when indexing data).
+    size_t head = 0;
+    size_t tail = 0;
+
+    bool has_readers = true; ///< Cleared when the last reading handle is closed.
+    bool has_writers = true; ///< Cleared when the last writing handle is closed.
+
+    // These are used as wait queues only: Their count stays 0.
+    semaphore_t readable { 0, {} }; ///< Readers waiting for data.
+    semaphore_t writable { 0, {} }; ///< Writers waiting for space.
+
+    Poll::waitq_t pollers; ///< Threads polling either end.
+
+    ~pipe_t() { Poll::detach_queue(pollers); }
+
+    size_t used() const { return tail - head; }
+    size_t free() const { return pipe_size - used(); }
+
+    /**
+     * Read from the pipe.
+     *
+     * Blocks until at least one byte is available.
+     *
+     * \return the amount of bytes read, or 0 (EOF) if the pipe is empty
+     *         and has no writers left.
+     */
+    ssize_t read(void *buffer, size_t nbytes);
+
+    /**
+     * Write to the pipe.
+     *
+     * Blocks until all bytes are written.
+     *
+     * \return the amount of bytes written, or ERR_io if there are no readers
+     *         left and nothing could be written.
+     */
+    ssize_t write(const void *buffer, size_t nbytes);
+
+    /// Readiness for poll() (for both ends: the caller masks by handle flags).
+    poll_events_t poll(Poll::waitq_t *&queue);
+
+    /// Update reader/writer state after a handle was closed,
+    /// waking up anyone that is waiting for the other side.
+    void close_end(bool readers_left, bool writers_left);
 };
@@ -57,6 +57,19 @@ struct dir_entry_t {
     inode_t inode;
 };
 
+/**
+ * A read position within a directory.
+ *
+ * `i` is an implementation-defined index number (see Fs::read_dir).
+ * Filesystems may remember where they left off in `hint`, so that reading a
+ * directory sequentially does not require locating every entry from scratch.
+ * A hint of 0 means that the filesystem must go by `i` alone.
+ */
+struct dir_pos_t {
+    u64 i    = 0;
+    u64 hint = 0;
+};
+
 namespace FileSystem { class Fs; }
 
 /**
@@ -74,6 +87,11 @@ struct file_t {
     // A linked list containing all current handles for this file.
     file_handle_t *first_handle = nullptr;
     file_handle_t  *last_handle = nullptr;
+
+    // Links within the VFS' open file indices.
+    u32     path_hash     = 0;
+    file_t *next_by_path  = nullptr;
+    file_t *next_by_inode = nullptr;
 };
 
 namespace Process { struct proc_t; }
@@ -91,6 +109,12 @@ struct file_handle_t {
     file_t      *file       = nullptr;
     open_flags_t flags      = 0;
     u64          pos        = 0;
+    u64          dir_hint   = 0; ///< \see dir_pos_t
+
+    // Sequential readahead state (see Vfs::read).
+    u64          ra_next    = 0; ///< Where a sequential read would continue.
+    u64          ra_end     = 0; ///< End of the data that was read ahead so far.
+    u32          ra_window  = 0; ///< Bytes to read ahead, 0 while reads are not sequential.
 
     Process::proc_t *proc   = nullptr; ///< owner proc.
     fd_t             procfd = -1;      ///< fd number within the proc.
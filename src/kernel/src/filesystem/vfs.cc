@@ -16,18 +16,24 @@
 #include "filesystem/filesystem.hh"
 #include "process/proc.hh"
 #include "filesystem/pipe.hh"
+#include "filesystem/dcache.hh"
+#include "filesystem/page-cache.hh"
+#include "ipc/rwlock.hh"
+#include "memory/kernel-heap.hh"
 
 namespace Vfs {
 
     /**
-     * A lock that prevents multiple threads from opening / closing files
-     * simultaneously, among other operations.
+     * A lock that protects the VFS tables (mounts, open files and handles).
      *
-     * This is a shotgun-approach to preventing synchronisation issues:
-     * A significant amount of potential performance is sacrificed, but in
-     * return our open() and close() functions can avoid some complexity.
+     * Path lookups only take the lock shared, so that, for example, several
+     * processes reading from /bin do not queue up behind each other while
+     * their lookups wait for the disk. Anything that changes the tables
+     * (registering or closing files, creating pipes, modifying directories)
+     * takes it exclusively.
      *
-     * To give an idea of what issues we would have to deal with:
+     * Exclusive sections avoid a lot of complexity. To give an idea of what
+     * issues we would otherwise have to deal with:
      * Consider two threads trying to open the same file simultaneously.
      * The first thread creates the open_file_t structure, since none yet
      * exists. However, the thread needs to read from disk in order to fill the
@@ -45,21 +51,23 @@ namespace Vfs {
      * to somehow mark the handle unusable for the duration of thread 1's open
      * call.
      *
-     * This, and more, is avoided by making certain "open" and "close" actions
-     * atomic relative to themselves and eachother. i.e. all open and close
-     * calls are serialised.
+     * open() avoids this by doing the (slow) lookup into a private file
+     * struct under a shared lock, and then registering the file under an
+     * exclusive lock, re-checking whether another thread got there first.
      */
-    mutex_t vfs_lock;
+    rwlock_t vfs_lock;
 
     /**
      * Waits until the vfs is unlocked.
      *
-     * The kernel is not pre-emptible, so when this function returns, the lock
-     * is guaranteed to remain unlocked until the next yield.
+     * Kernel code only switches threads when it blocks or reaches a
+     * preempt_point(), so when this function returns, the lock is
+     * guaranteed to remain unlocked until the caller does either.
+     * (delete_thread and delete_proc rely on this: They do neither between
+     *  calling this and closing the process' files)
      */
     void wait_until_lockable() {
-        mutex_lock(vfs_lock);
-        mutex_unlock(vfs_lock);
+        wait_until_unlocked(vfs_lock);
     }
 
     using namespace FileSystem;
@@ -72,6 +80,13 @@ namespace Vfs {
     /// to it), has a unique entry in the open_files array.
     static Array<       file_t*, max_open_files>   open_files;
 
+    /// Open files are also indexed by path and by inode, so that finding an
+    /// open file does not require comparing paths against every entry.
+    static constexpr size_t open_file_buckets = 64; ///< (must be a power of two)
+
+    static Array<file_t*, open_file_buckets> files_by_path;
+    static Array<file_t*, open_file_buckets> files_by_inode;
+
     /// Each file descriptor (fd) has a unique entry in handle array.
     static Array<file_handle_t*, max_file_handles> handles;
 
@@ -166,7 +181,15 @@ namespace Vfs {
             path.pop_front(component.length() + 1);
 
             assert(node_.fs, "fs not set in inode");
-            errno_t err = node_.fs->lookup(tmp_node, component, dest);
+
+            errno_t err;
+            bool cache = node_.fs->cache_lookups();
+
+            if (!cache || !Dcache::find(tmp_node, component, dest, err)) {
+                err = node_.fs->lookup(tmp_node, component, dest);
+                if (cache)
+                    Dcache::insert(tmp_node, component, err, dest);
+            }
             if (err) return err;
 
             tmp_node = dest;
@@ -207,14 +230,80 @@ namespace Vfs {
         return ERR_limit;
     }
 
-    static int find_open_file(const path_t &path) {
-        for (auto [i, open_file] : enumerate(open_files)) {
-            if (open_file && open_file->path == path)
-                return i;
+    // }}}
+    // Open file indices. {{{
+
+    /// Whether two inodes refer to the same file.
+    /// (the context values are included since e.g. FAT32 inode numbers are not unique)
+    static bool same_inode(const inode_t &a, const inode_t &b) {
+        return a.fs       == b.fs
+            && a.i        == b.i
+            && a.context1 == b.context1
+            && a.context2 == b.context2;
+    }
+
+    static file_t *&inode_bucket(const inode_t &inode) {
+        u32 h = (u32)inode.i        * 2654435761u
+              ^ (u32)inode.context1 * 40503u
+              ^ (u32)inode.context2
+              ^ (u32)(addr_t)inode.fs;
+        return files_by_inode[h & (open_file_buckets - 1)];
+    }
+
+    static file_t *find_open_file(const path_t &path) {
+        u32 h = str_hash(path);
+        for (file_t *f = files_by_path[h & (open_file_buckets - 1)]; f; f = f->next_by_path) {
+            // Only compare paths on hash hits.
+            if (f->path_hash == h && f->path == path)
+                return f;
+        }
+        return nullptr;
+    }
+
+    /// Find an open file by inode (only files on a filesystem are indexed).
+    static file_t *find_open_file(const inode_t &inode) {
+        if (!inode.fs) return nullptr;
+
+        for (file_t *f = inode_bucket(inode); f; f = f->next_by_inode) {
+            if (same_inode(f->inode, inode))
+                return f;
+        }
+        return nullptr;
+    }
+
+    /// Register a file in the open_files array and the indices.
+    static void register_open_file(file_t *file) {
+        open_files[file->file_i] = file;
+
+        file->path_hash = str_hash(file->path);
+
+        file_t *&by_path = files_by_path[file->path_hash & (open_file_buckets - 1)];
+        file->next_by_path = by_path;
+        by_path = file;
+
+        if (file->inode.fs) {
+            file_t *&by_inode = inode_bucket(file->inode);
+            file->next_by_inode = by_inode;
+            by_inode = file;
+        }
+    }
+
+    static void unregister_open_file(file_t *file) {
+        open_files[file->file_i] = nullptr;
+
+        for (file_t **p = &files_by_path[file->path_hash & (open_file_buckets - 1)]; *p; p = &(*p)->next_by_path) {
+            if (*p == file) { *p = file->next_by_path; break; }
+        }
+        if (file->inode.fs) {
+            for (file_t **p = &inode_bucket(file->inode); *p; p = &(*p)->next_by_inode) {
+                if (*p == file) { *p = file->next_by_inode; break; }
+            }
         }
-        return -1;
     }
 
+    // }}}
+    // Functions that allocate file numbers (continued). {{{
+
     static int alloc_file_i() {
         for (auto [i, open_file] : enumerate(open_files)) {
             if (open_file == nullptr)
@@ -390,8 +479,6 @@ namespace Vfs {
 
     fd_t open(int fd, StringView path_, open_flags_t flags) {
 
-        locked_within_scope _(vfs_lock);
-
         // First of all, add some implied open flags for the convenience of the user.
         if (flags & o_dir)      flags |= o_read ;
         if (flags & o_append)   flags |= o_write;
@@ -407,27 +494,47 @@ namespace Vfs {
         // A temporary file struct that will be used when opening a file
         // for which no file_t struct has been allocated yet.
         file_t tmp_file;
+        bool   have_tmp_file = false;
+
+        {
+            // Look the file up under a shared lock: Other lookups (which may
+            // need to wait for the disk) can proceed at the same time.
+            read_locked_within_scope _(vfs_lock);
 
-        // We might have this file open somewhere already.
-        int open_file_i = find_open_file(path);
+            // We might have this file open somewhere already.
+            if (!find_open_file(path)) {
+                // File is not open yet: We need to find it first.
+                err = make_file_struct(path, tmp_file);
+                if (err) return err;
 
-        file_t *open_file = nullptr;
+                have_tmp_file = true;
+            }
+        }
 
-        if (open_file_i >= 0) {
-            // We do! Simply use that one.
-            open_file = open_files[open_file_i];
+        // From here on we modify the vfs tables.
+        write_locked_within_scope _(vfs_lock);
 
-        } else {
-            // File is not open yet: We need to find it first.
+        // Re-check: Another thread may have opened (or closed) the file
+        // while we did not hold the lock.
+        file_t *open_file   = find_open_file(path);
+        int     open_file_i = -1;
 
-            // But first, make sure we actually have room for opening a new file.
+        if (!open_file) {
+            if (!have_tmp_file) {
+                // The file was closed in the meantime.
+                err = make_file_struct(path, tmp_file);
+                if (err) return err;
+            }
+
+            // The file may still be open under a different path.
+            open_file = find_open_file(tmp_file.inode);
+        }
+
+        if (!open_file) {
+            // Make sure we actually have room for opening a new file.
             open_file_i = alloc_file_i();
             if (open_file_i < 0) return open_file_i;
 
-            // Find the file, make sure it exists.
-            err = make_file_struct(path, tmp_file);
-            if (err) return err;
-
             // We succesfully found the file.
             // (we will put this in the open_files list once we're done below)
             open_file = &tmp_file;
@@ -478,8 +585,8 @@ namespace Vfs {
             open_file = new file_t(tmp_file);
             if (!open_file) { delete handle; return ERR_nomem; }
 
-            open_file->file_i       = open_file_i;
-            open_files[open_file_i] = open_file;
+            open_file->file_i = open_file_i;
+            register_open_file(open_file);
         }
 
         // Fill handle struct.
@@ -522,7 +629,7 @@ namespace Vfs {
 
     fd_t duplicate_fd(fd_t dest, fd_t fd) {
 
-        locked_within_scope _(vfs_lock);
+        write_locked_within_scope _(vfs_lock);
 
         file_handle_t *src = handle_by_fd(fd);
         if (!src) return ERR_bad_fd;
@@ -596,7 +703,7 @@ namespace Vfs {
 
     errno_t make_pipe(fd_t &in, fd_t &out) {
 
-        locked_within_scope _(vfs_lock);
+        write_locked_within_scope _(vfs_lock);
 
         Process::proc_t *proc = Process::current_proc();
         assert(proc, "no running process");
@@ -665,7 +772,7 @@ namespace Vfs {
         file->inode.fs   = nullptr;
 
         // Register file and handles.
-        open_files[open_file_i] = file;
+        register_open_file(file);
 
         handles[ in_handle_i] =  in_handle;
         handles[out_handle_i] = out_handle;
@@ -681,7 +788,7 @@ namespace Vfs {
 
     errno_t close(fd_t fd) {
 
-        locked_within_scope _(vfs_lock);
+        write_locked_within_scope _(vfs_lock);
 
         Process::proc_t *proc = Process::current_proc();
         assert(proc, "no running process");
@@ -707,6 +814,18 @@ namespace Vfs {
 
         delete handle;
 
+        if (file->inode.type == t_pipe) {
+            // Tell the other side of the pipe when the last reader or writer
+            // goes away (this is how readers get an EOF).
+            bool readers_left = false;
+            bool writers_left = false;
+            for (file_handle_t *h = file->first_handle; h; h = h->next) {
+                if (h->flags & o_read)  readers_left = true;
+                if (h->flags & o_write) writers_left = true;
+            }
+            ((pipe_t*)file->inode.i)->close_end(readers_left, writers_left);
+        }
+
         if (file->first_handle == nullptr) {
             // We deleted the last handle for this open file.
             // Clean up the file.
@@ -716,7 +835,7 @@ namespace Vfs {
                 delete (pipe_t*)file->inode.i;
             }
 
-            open_files[file->file_i] = nullptr;
+            unregister_open_file(file);
             delete file;
         }
 
@@ -733,9 +852,98 @@ namespace Vfs {
 
         locked_within_scope _(handle->lock);
 
+        // Any directory read position hint is no longer valid.
+        handle->dir_hint = 0;
+
         return handle->file->inode.fs->seek(handle->file->inode, handle->pos, dir, off);
     }
 
+    // Readahead window limits.
+    static constexpr u32 readahead_min = 16_KiB;
+    static constexpr u32 readahead_max = 512_KiB;
+
+    /**
+     * Update the readahead state of a handle after a read, and start reading
+     * the next part of the file into the page cache if access is sequential.
+     *
+     * The window doubles on each sequential read, and shrinks on random access.
+     */
+    static void read_ahead(file_handle_t &handle, u64 pos, size_t nbytes) {
+
+        if (pos == handle.ra_next) {
+            handle.ra_window = clamp(readahead_min, readahead_max, handle.ra_window * 2);
+        } else {
+            handle.ra_window /= 4;
+            if (handle.ra_window < readahead_min)
+                handle.ra_window = 0;
+            handle.ra_end = 0;
+        }
+
+        handle.ra_next = pos + nbytes;
+
+        if (!handle.ra_window) return;
+
+        // Only request data that was not requested before, and wait until
+        // there's a reasonable amount of it.
+        u64 start = max(handle.ra_next, handle.ra_end);
+        u64 end   = handle.ra_next + handle.ra_window;
+
+        if (end > start && end - start >= handle.ra_window / 2) {
+            PageCache::readahead(handle.file->inode, start, end - start);
+            handle.ra_end = end;
+        }
+    }
+
+    /// Read from a locked handle.
+    static ssize_t read_locked(file_handle_t &handle, void *buffer, size_t nbytes) {
+
+        if (nbytes == 0) return 0;
+
+        if (handle.file->inode.type == t_pipe)
+            return ((pipe_t*)handle.file->inode.i)->read(buffer, nbytes);
+
+        inode_t &inode = handle.file->inode;
+
+        assert(inode.fs ,"no filesystem set for inode");
+
+        ssize_t res;
+
+        if (inode.fs->cache_pages(inode)) {
+            res = PageCache::read(inode, handle.pos, buffer, nbytes);
+            if (res > 0)
+                read_ahead(handle, handle.pos, res);
+        } else {
+            res = inode.fs->read(inode, handle.pos, buffer, nbytes);
+        }
+
+        if (res < 0) return res;
+        handle.pos += res;
+        return res;
+    }
+
+    /// Write to a locked handle.
+    static ssize_t write_locked(file_handle_t &handle, const void *buffer, size_t nbytes) {
+
+        if (nbytes == 0) return 0;
+
+        if (handle.file->inode.type == t_pipe)
+            return ((pipe_t*)handle.file->inode.i)->write(buffer, nbytes);
+
+        inode_t &inode = handle.file->inode;
+
+        assert(inode.fs ,"no filesystem set for inode");
+
+        ssize_t res = inode.fs->write(inode, handle.pos, buffer, nbytes);
+
+        // Cached data may have been (partially) overwritten, even on failure.
+        if (inode.fs->cache_pages(inode))
+            PageCache::invalidate(inode, handle.pos, nbytes);
+
+        if (res < 0) return res;
+        handle.pos += res;
+        return res;
+    }
+
     ssize_t read(fd_t fd, void *buffer, size_t nbytes) {
 
         // Acquire a lock on the handle, so we don't read and write at the same time.
@@ -748,17 +956,7 @@ namespace Vfs {
         if (  handle->flags & o_dir)   return ERR_type;
         if (!(handle->flags & o_read)) return ERR_type;
 
-        if (nbytes == 0) return 0;
-
-        assert(handle->file->inode.fs ,"no filesystem set for inode");
-
-        ssize_t res = handle->file->inode.fs->read(handle->file->inode
-                                                  ,handle->pos
-                                                  ,buffer, nbytes);
-
-        if (res < 0) return res;
-        handle->pos += res;
-        return res;
+        return read_locked(*handle, buffer, nbytes);
     }
 
     ssize_t write(fd_t fd, const void *buffer, size_t nbytes) {
@@ -773,17 +971,198 @@ namespace Vfs {
         if (  handle->flags & o_dir)    return ERR_type;
         if (!(handle->flags & o_write)) return ERR_type;
 
-        if (nbytes == 0) return 0;
+        return write_locked(*handle, buffer, nbytes);
+    }
 
-        assert(handle->file->inode.fs ,"no filesystem set for inode");
+    ssize_t readv(fd_t fd, const syscall_iovec_t *iov, size_t count) {
 
-        ssize_t res = handle->file->inode.fs->write(handle->file->inode
-                                                   ,handle->pos
-                                                   ,buffer, nbytes);
+        file_handle_t *handle = handle_by_fd(fd);
+        if (!handle) return ERR_bad_fd;
 
-        if (res < 0) return res;
-        handle->pos += res;
-        return res;
+        // One lock for all segments: They are read as one contiguous range.
+        locked_within_scope _(handle->lock);
+
+        if (  handle->flags & o_dir)   return ERR_type;
+        if (!(handle->flags & o_read)) return ERR_type;
+
+        bool    is_pipe = handle->file->inode.type == t_pipe;
+        ssize_t total   = 0;
+
+        for (size_t i : range(count)) {
+            // Do not block on an empty pipe once we have data to return.
+            if (is_pipe && total && !((pipe_t*)handle->file->inode.i)->used())
+                break;
+
+            ssize_t res = read_locked(*handle, iov[i].data, iov[i].size);
+            if (res < 0) return total ? total : res;
+
+            total += res;
+            if ((size_t)res < iov[i].size)
+                break;
+        }
+
+        return total;
+    }
+
+    ssize_t writev(fd_t fd, const syscall_iovec_t *iov, size_t count) {
+
+        file_handle_t *handle = handle_by_fd(fd);
+        if (!handle) return ERR_bad_fd;
+
+        // One lock for all segments: Writes by others cannot end up in between.
+        locked_within_scope _(handle->lock);
+
+        if (  handle->flags & o_dir)    return ERR_type;
+        if (!(handle->flags & o_write)) return ERR_type;
+
+        ssize_t total = 0;
+
+        for (size_t i : range(count)) {
+            ssize_t res = write_locked(*handle, iov[i].data, iov[i].size);
+            if (res < 0) return total ? total : res;
+
+            total += res;
+            if ((size_t)res < iov[i].size)
+                break;
+        }
+
+        return total;
+    }
+
+    ssize_t copy_range(fd_t fd_in, fd_t fd_out, size_t nbytes) {
+
+        file_handle_t *in  = handle_by_fd(fd_in);
+        file_handle_t *out = handle_by_fd(fd_out);
+        if (!in || !out) return ERR_bad_fd;
+        if (in == out)   return ERR_invalid;
+
+        // Always lock in the same order, so that two copies in opposite
+        // directions cannot deadlock.
+        file_handle_t *first  = in->handle_i < out->handle_i ? in  : out;
+        file_handle_t *second = in->handle_i < out->handle_i ? out : in;
+
+        locked_within_scope _1(first->lock);
+        locked_within_scope _2(second->lock);
+
+        if ( (in ->flags & o_dir) || !(in ->flags & o_read )) return ERR_type;
+        if ( (out->flags & o_dir) || !(out->flags & o_write)) return ERR_type;
+
+        nbytes = min(nbytes, (size_t)intmax<ssize_t>::value);
+        if (!nbytes) return 0;
+
+        // Data is moved through a kernel buffer in large chunks.
+        // (filesystems do not support copying data themselves, yet)
+        static constexpr size_t chunk_size = 32_KiB;
+
+        size_t buffer_size = min(nbytes, chunk_size);
+        u8    *buffer      = (u8*)Memory::Heap::alloc(buffer_size, 512);
+        if (!buffer) return ERR_nomem;
+
+        ON_RETURN(Memory::Heap::free(buffer));
+
+        bool    is_pipe = in->file->inode.type == t_pipe;
+        ssize_t total   = 0;
+
+        while ((size_t)total < nbytes) {
+            // Do not block on an empty pipe once we have copied something.
+            if (is_pipe && total && !((pipe_t*)in->file->inode.i)->used())
+                break;
+
+            size_t  want = min(nbytes - total, buffer_size);
+            ssize_t got  = read_locked(*in, buffer, want);
+            if (got <  0) return total ? total : got;
+            if (got == 0) break;
+
+            ssize_t res = write_locked(*out, buffer, got);
+            if (res < 0) return total ? total : res;
+
+            total += res;
+            if (res < got || (size_t)got < want)
+                break;
+
+            Process::preempt_point();
+        }
+
+        return total;
+    }
+
+    ssize_t poll(fd_t fd, Poll::waitq_t *&queue) {
+
+        // Note: This does not lock the handle, it only queries state.
+        file_handle_t *handle = handle_by_fd(fd);
+        if (!handle) return ERR_bad_fd;
+
+        inode_t &inode = handle->file->inode;
+
+        poll_events_t events;
+        queue = nullptr;
+
+        if (inode.type == t_pipe)
+            events = ((pipe_t*)inode.i)->poll(queue);
+        else if (inode.type == t_dir || !inode.fs)
+            events = poll_in;
+        else
+            events = inode.fs->poll(inode, queue);
+
+        // Only report what this handle can be used for.
+        if (!(handle->flags & o_read))  events &= ~poll_in;
+        if (!(handle->flags & o_write)) events &= ~poll_out;
+
+        return events;
+    }
+
+    errno_t stat(StringView path_, inode_t &dest) {
+
+        path_t path = canonicalise_path(path_);
+
+        read_locked_within_scope _(vfs_lock);
+
+        // Open files may have changed (e.g. grown) since they were looked up
+        // on disk, so their inode is leading.
+        if (file_t *file = find_open_file(path)) {
+            dest = file->inode;
+            return ERR_success;
+        }
+
+        return get_inode(path, dest);
+    }
+
+    errno_t fstat(fd_t fd, inode_t &dest) {
+
+        file_handle_t *handle = handle_by_fd(fd);
+        if (!handle) return ERR_bad_fd;
+
+        dest = handle->file->inode;
+
+        return ERR_success;
+    }
+
+    errno_t sync() {
+
+        errno_t result = ERR_success;
+
+        for (mount_t *m : mounts) {
+            if (!m) continue;
+
+            // Keep going on errors: Other filesystems may still be fine.
+            errno_t err = m->fs.sync();
+            if (err < 0) result = err;
+        }
+
+        return result;
+    }
+
+    errno_t fsync(fd_t fd) {
+
+        file_handle_t *handle = handle_by_fd(fd);
+        if (!handle) return ERR_bad_fd;
+
+        inode_t &inode = handle->file->inode;
+
+        if (inode.type == t_pipe || !inode.fs)
+            return ERR_invalid;
+
+        return inode.fs->sync();
     }
 
     ssize_t read_dir(fd_t fd, dir_entry_t &dest) {
@@ -814,9 +1193,13 @@ namespace Vfs {
         } else {
             assert(handle->file->inode.fs, "handle does not have a fs");
 
+            dir_pos_t pos { handle->pos, handle->dir_hint };
+
             // deref all the things!
-            errno_t err = handle->file->inode.fs->read_dir(handle->file->inode, handle->pos, dest);
-            // handle->pos is updated by the read_dir call above.
+            errno_t err = handle->file->inode.fs->read_dir(handle->file->inode, pos, dest);
+
+            handle->pos      = pos.i;
+            handle->dir_hint = pos.hint;
 
             return err;
         }
@@ -828,10 +1211,10 @@ namespace Vfs {
 
         path_t path = canonicalise_path(path_);
 
-        locked_within_scope _(vfs_lock);
+        write_locked_within_scope _(vfs_lock);
 
         // Prevent removing files that are currently open.
-        if (find_open_file(path) >= 0) return ERR_in_use;
+        if (find_open_file(path)) return ERR_in_use;
 
         file_name_t base = basename(path);
 
@@ -842,7 +1225,11 @@ namespace Vfs {
         if (parent.type != t_dir) return ERR_type;
         if (!parent.fs)           return ERR_not_supported; // (for the vfs root)
 
-        return parent.fs->unlink(parent, base);
+        err = parent.fs->unlink(parent, base);
+        if (err >= 0)
+            Dcache::invalidate(parent, base);
+
+        return err;
     }
 
     ssize_t rmdir (StringView path_) {
@@ -852,7 +1239,7 @@ namespace Vfs {
         path_t path      = canonicalise_path(path_);
         file_name_t base = basename(path);
 
-        locked_within_scope _(vfs_lock);
+        write_locked_within_scope _(vfs_lock);
 
         inode_t parent;
         errno_t err = get_inode(path, parent);
@@ -861,7 +1248,12 @@ namespace Vfs {
         if (parent.type != t_dir) return ERR_type;
         if (!parent.fs)           return ERR_not_supported; // (for the vfs root)
 
-        return parent.fs->rmdir(parent, base);
+        err = parent.fs->rmdir(parent, base);
+        if (err >= 0)
+            // Lookups within the directory are cached as well.
+            Dcache::invalidate_all();
+
+        return err;
     }
 
     ssize_t mkdir (StringView path_) {
@@ -871,7 +1263,7 @@ namespace Vfs {
         path_t path      = canonicalise_path(path_);
         file_name_t base = basename(path);
 
-        locked_within_scope _(vfs_lock);
+        write_locked_within_scope _(vfs_lock);
 
         inode_t parent;
         errno_t err = get_inode(path, parent);
@@ -880,7 +1272,12 @@ namespace Vfs {
         if (parent.type != t_dir) return ERR_type;
         if (!parent.fs)           return ERR_not_supported; // (for the vfs root)
 
-        return parent.fs->mkdir(parent, base);
+        err = parent.fs->mkdir(parent, base);
+        if (err >= 0)
+            // (there may be a negative entry)
+            Dcache::invalidate(parent, base);
+
+        return err;
     }
 
     ssize_t rename(StringView src_, StringView dst_) {
@@ -900,7 +1297,7 @@ namespace Vfs {
 
         // (src and dst are now the paths to the containing directories)
 
-        locked_within_scope _(vfs_lock);
+        write_locked_within_scope _(vfs_lock);
 
         errno_t err;
 
@@ -918,8 +1315,13 @@ namespace Vfs {
             // (or maybe we can leave this to userland instead?)
             return ERR_not_supported;
 
-        return src_parent.fs->rename(src_parent, src_base
-                                    ,dst_parent, dst_base);
+        err = src_parent.fs->rename(src_parent, src_base
+                                   ,dst_parent, dst_base);
+        if (err >= 0)
+            // A moved directory takes its contents along.
+            Dcache::invalidate_all();
+
+        return err;
     }
 
     void init() {
@@ -927,6 +1329,8 @@ namespace Vfs {
         assert(devfs, "could not allocate devfs");
         assert(mount(*devfs, "dev") == 0, "could not mount devfs");
 
+        PageCache::init();
+
         // FIXME: This does not belong here.
         static DevFs::memory_device_t text {Memory::region_t{ 0xb8000, 25*80*2 } };
         devfs->register_device("video-text", text, 0600);
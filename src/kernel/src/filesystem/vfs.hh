@@ -19,6 +19,7 @@
 #include "types.hh"
 #include "filesystem.hh"
 #include "filesystem/devfs.hh"
+#include <syscall-numbers.hh>
 
 /**
  * The virtual filesystem.
@@ -60,9 +61,56 @@ namespace Vfs {
 
     ssize_t read (fd_t fd,       void *buffer, size_t nbytes);
     ssize_t write(fd_t fd, const void *buffer, size_t nbytes);
+
+    /**
+     * Vectored I/O: Read into / write from multiple buffers in order, as a
+     * single operation on the file handle.
+     *
+     * Stops at the first short transfer.
+     * Buffers must have been validated by the caller.
+     *
+     * \return the total amount of bytes transferred, or an error code below 0
+     *         if nothing could be transferred.
+     */
+    ssize_t readv (fd_t fd, const syscall_iovec_t *iov, size_t count);
+    ssize_t writev(fd_t fd, const syscall_iovec_t *iov, size_t count);
+
+    /**
+     * Copy up to `nbytes` from one file to another, starting at the current
+     * position of each handle, without passing the data through userspace.
+     *
+     * Stops at the end of the input file or at the first short write.
+     *
+     * \return the amount of bytes copied, or an error code below 0 if nothing
+     *         could be copied.
+     */
+    ssize_t copy_range(fd_t fd_in, fd_t fd_out, size_t nbytes);
+
     ssize_t read_dir(fd_t fd, dir_entry_t &dest);
     errno_t truncate(fd_t fd);
 
+    /**
+     * Get a file's metadata, without opening it.
+     *
+     * No file_t or file_handle_t is allocated for this.
+     */
+    errno_t stat(StringView path, inode_t &dest);
+
+    /// Get the metadata of an open file.
+    errno_t fstat(fd_t fd, inode_t &dest);
+
+    /// Write all modified data of all filesystems to disk.
+    /// \return the last error encountered, if any.
+    errno_t sync();
+
+    /// Write the modified data of a file to disk.
+    /// (depending on the filesystem, this may write other files' data as well)
+    errno_t fsync(fd_t fd);
+
+    /// Get the poll events of a file (masked by the handle's open flags).
+    /// If the file may block, `queue` is set to a wait queue to poll on.
+    ssize_t poll(fd_t fd, Poll::waitq_t *&queue);
+
     // (leave dest empty or -1 to allocate a file number automatically).
     fd_t duplicate_fd(fd_t dest, fd_t fd);
 
@@ -18,6 +18,7 @@
 #include "../memory/gdt.hh"
 #include "../debug-keys.hh"
 #include "../process/proc.hh"
+#include "../process/fpu.hh"
 #include "syscall.hh"
 
 /**
@@ -146,6 +147,10 @@ namespace Interrupt::Handler {
             // Ok!
             return;
 
+        // FPU use by a thread whose FPU state is not loaded (lazy switching).
+        if (frame.int_no == 0x07 && Process::Fpu::handle_trap(frame))
+            return;
+
         // In any other case, the running thread is killed.
         // If kernel code caused the problem, it's time to panic.
 
@@ -15,6 +15,7 @@
 #include "interrupt.hh"
 #include "controller.hh"
 #include "idt.hh"
+#include "syscall.hh"
 
 namespace Interrupt {
 
@@ -29,5 +30,6 @@ namespace Interrupt {
     void init() {
         Controller::init();
         Idt::init();
+        Syscall::init();
     }
 }
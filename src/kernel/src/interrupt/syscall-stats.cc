@@ -0,0 +1,128 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "syscall-stats.hh"
+#include "filesystem/vfs.hh"
+
+#include <syscall-numbers.hh>
+
+namespace Interrupt::Syscall::Stats {
+
+    Array<stat_t, max_syscalls> stats;
+
+    static StringView syscall_name(u32 nr) {
+        switch (nr) {
+        case SYS_YIELD:         return "yield";
+        case SYS_GET_TID:       return "get_tid";
+        case SYS_GET_PID:       return "get_pid";
+        case SYS_THREAD_DELETE: return "thread_delete";
+        case SYS_OPEN:          return "open";
+        case SYS_CLOSE:         return "close";
+        case SYS_READ:          return "read";
+        case SYS_WRITE:         return "write";
+        case SYS_READ_DIR:      return "read_dir";
+        case SYS_SEEK:          return "seek";
+        case SYS_SPAWN:         return "spawn";
+        case SYS_WAIT_PID:      return "wait_pid";
+        case SYS_GET_CWD:       return "get_cwd";
+        case SYS_SET_CWD:       return "set_cwd";
+        case SYS_DUPLICATE_FD:  return "duplicate_fd";
+        case SYS_PIPE:          return "pipe";
+        case SYS_THREAD_CREATE: return "thread_create";
+        case SYS_FUTEX_WAIT:    return "futex_wait";
+        case SYS_FUTEX_WAKE:    return "futex_wake";
+        case SYS_PORT_CREATE:   return "port_create";
+        case SYS_PORT_DESTROY:  return "port_destroy";
+        case SYS_PORT_LOOKUP:   return "port_lookup";
+        case SYS_PORT_SEND:     return "port_send";
+        case SYS_PORT_RECEIVE:  return "port_receive";
+        case SYS_PORT_CALL:     return "port_call";
+        case SYS_PORT_REPLY:    return "port_reply";
+        case SYS_POLL:          return "poll";
+        case SYS_READV:         return "readv";
+        case SYS_WRITEV:        return "writev";
+        case SYS_RING_SETUP:    return "ring_setup";
+        case SYS_RING_ENTER:    return "ring_enter";
+        case SYS_GET_DENTS:     return "get_dents";
+        case SYS_STAT:          return "stat";
+        case SYS_FSTAT:         return "fstat";
+        case SYS_COPY_RANGE:    return "copy_range";
+        case SYS_SYNC:          return "sync";
+        case SYS_FSYNC:         return "fsync";
+        }
+        return "?";
+    }
+
+    void reset() {
+        for (stat_t &s : stats)
+            s = stat_t {};
+    }
+
+    /**
+     * Format statistics as text.
+     *
+     * One line per syscall that was called at least once. The histogram is
+     * printed as a list of `log2(cycles):count` pairs for non-empty buckets.
+     */
+    template<typename F>
+    static void format(F &&print) {
+        print("{-3} {-14} {10} {8} {10} {}\n"
+             ,"NR", "NAME", "CALLS", "ERRORS", "AVG-CYC", "HISTOGRAM");
+
+        for (auto [nr, s] : enumerate(stats)) {
+            if (!s.calls) continue;
+
+            print("{3} {-14} {10} {8} {10} "
+                 ,nr
+                 ,syscall_name(nr)
+                 ,s.calls
+                 ,s.errors
+                 ,s.cycles / s.calls);
+
+            for (auto [i, n] : enumerate(s.histogram)) {
+                if (n) print(" {}:{}", i, n);
+            }
+            print("\n");
+        }
+    }
+
+    void dump() {
+        format([] (StringView s, const auto&... args) { kprint(s, args...); });
+    }
+
+    /// Device /dev/syscall-stats.
+    static struct stats_device_t : public DevFs::line_device_t<8_K> {
+
+        errno_t get(String<8_K> &str) override {
+            str = "";
+            format([&] (StringView s, const auto&... args) {
+                // Rather truncate than overflow. (a line is at most ~500 chars)
+                if (str.length() + 512 < str.size())
+                    fmt(str, s, args...);
+            });
+            return ERR_success;
+        }
+
+        errno_t set(StringView v) override {
+            if (v != "0") return ERR_invalid;
+            reset();
+            return ERR_success;
+        }
+    } stats_device;
+
+    void init() {
+        DevFs *devfs = Vfs::get_devfs();
+        if (devfs) devfs->register_device("syscall-stats", stats_device, 0644);
+    }
+}
@@ -0,0 +1,70 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include <syscall-numbers.hh>
+
+/**
+ * Per-syscall statistics.
+ *
+ * For every system call number, the dispatcher records the amount of calls,
+ * the amount of calls that returned an error, and the time spent in the
+ * kernel (in TSC cycles, including time spent blocked), both cumulative and
+ * as a log2 histogram.
+ *
+ * Statistics are exposed as /dev/syscall-stats (write '0' to reset them)
+ * and through the `sysstat` kshell command.
+ */
+namespace Interrupt::Syscall::Stats {
+
+    /// Syscall numbers beyond this are not recorded.
+    static constexpr size_t max_syscalls = SYS_COUNT;
+
+    /// Histogram bucket i counts calls that took [2^i, 2^(i+1)) cycles.
+    static constexpr size_t histogram_buckets = 32;
+
+    struct stat_t {
+        u64 calls  = 0;
+        u64 errors = 0;
+        u64 cycles = 0;
+        Array<u32, histogram_buckets> histogram;
+    };
+
+    extern Array<stat_t, max_syscalls> stats;
+
+    /// Record a completed system call.
+    inline void record(u32 nr, u64 cycles, bool error) {
+        if (nr >= max_syscalls) return;
+
+        stat_t &s = stats[nr];
+
+        s.calls++;
+        s.errors += error;
+        s.cycles += cycles;
+
+        // (the highest set bit, cycles | 1 avoids clz(0))
+        u32 bucket = 63 - __builtin_clzll(cycles | 1);
+        s.histogram[min(bucket, histogram_buckets - 1)]++;
+    }
+
+    void reset();
+
+    /// Print statistics to the console.
+    void dump();
+
+    /// Registers /dev/syscall-stats (needs to be run after the VFS is initialised).
+    void init();
+}
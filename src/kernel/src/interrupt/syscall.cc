@@ -13,25 +13,28 @@
  * limitations under the License.
  */
 #include "syscall.hh"
+#include "syscall-stats.hh"
 #include "process/proc.hh"
 
 #include "filesystem/vfs.hh"
 #include "memory/manager-virtual.hh"
 #include "memory/layout.hh"
 #include "ipc/semaphore.hh"
+#include "ipc/futex.hh"
+#include "ipc/port.hh"
+#include "ipc/poll.hh"
+#include "ipc/io-ring.hh"
 #include "process/elf.hh"
+#include "memory/gdt.hh"
 
 #include <syscall-numbers.hh>
 
+/// SYSENTER entrypoint (see Syscall::init).
+extern "C" [[gnu::naked]] void sysenter_entry();
+
 namespace Interrupt::Syscall {
 
-    /**
-     * Verify that a user-provided buffer is valid.
-     *
-     * A buffer syscall argument must lie completely within user memory,
-     * and must be mapped (resident) in its entirety.
-     */
-    static bool is_buffer_valid(Memory::region_t region) {
+    bool is_buffer_valid(Memory::region_t region) {
         return region_valid(region) // Does addr+size not overflow?
             && region_contains(Memory::Layout::user(), region)
             && Memory::Virtual::is_mapped(region);
@@ -47,7 +50,44 @@ namespace Interrupt::Syscall {
             && is_buffer_valid(region);
     }
 
-    void handle_syscall(Interrupt::interrupt_frame_t &frame) {
+    /**
+     * Verify the buffers referenced by a user-provided IPC message.
+     *
+     * Page payloads must be page-aligned.
+     */
+    static bool is_message_valid(const syscall_message_t &msg) {
+        if (msg.size
+         && !is_buffer_valid(Memory::region_t { (addr_t)msg.data, msg.size }
+                            ,ipc_inline_max))
+            return false;
+
+        if (msg.pages_size
+         && ((((addr_t)msg.pages | msg.pages_size) & (page_size - 1))
+          || !is_buffer_valid(Memory::region_t { (addr_t)msg.pages, msg.pages_size })))
+            return false;
+
+        return true;
+    }
+
+    /// Convert a directory entry to its syscall representation.
+    static void copy_dir_entry(syscall_dir_entry_t &dest, const dir_entry_t &entry) {
+        str_copy(dest.name, entry.name.data(), entry.name.size());
+        dest.inode_i = entry.inode.i;
+        dest.type    = entry.inode.type;
+        dest.perm    = entry.inode.perm;
+        dest.size    = entry.inode.size;
+    }
+
+    /// Convert file metadata to its syscall representation.
+    static void copy_stat(syscall_stat_t &dest, const inode_t &inode) {
+        dest.inode_i = inode.i;
+        dest.type    = inode.type;
+        dest.perm    = inode.perm;
+        dest.size    = inode.size;
+    }
+
+    /// Execute a system call.
+    static void execute(Interrupt::interrupt_frame_t &frame) {
 
         // TODO: Instead of one long if/else train, we should create a vector
         //       table and a separate handler function for each syscall number.
@@ -96,6 +136,18 @@ namespace Interrupt::Syscall {
             // Hand CPU control over to the next runnable thread.
             Process::yield();
 
+        } else if (args[0] == SYS_GET_TID) {
+
+            // () => tid
+
+            ret = Process::current_thread()->id;
+
+        } else if (args[0] == SYS_GET_PID) {
+
+            // () => pid
+
+            ret = Process::current_proc()->id;
+
         } else if (args[0] == SYS_THREAD_DELETE) {
 
             // (pid) => ()
@@ -190,11 +242,74 @@ namespace Interrupt::Syscall {
             if ((s32)ret < 0)
                 kprint("read_dir result (fd {}): {}\n", args[1], error_name(ret));
 
-            str_copy(entry_out.name, entry.name.data(), entry.name.size());
-            entry_out.inode_i = entry.inode.i;
-            entry_out.type    = entry.inode.type;
-            entry_out.perm    = entry.inode.perm;
-            entry_out.size    = entry.inode.size;
+            copy_dir_entry(entry_out, entry);
+
+        } else if (args[0] == SYS_GET_DENTS) {
+
+            // (fd, buf*, buf_len) => entries_read
+
+            Memory::region_t buffer { args[2], args[3] };
+
+            if (!is_buffer_valid(buffer)
+              || buffer.size < sizeof(syscall_dir_entry_t)
+              || (buffer.start & (alignof(syscall_dir_entry_t)-1))) {
+                ret = ERR_invalid;
+                return;
+            }
+
+            // Fill as many entries as fit: The directory position is kept in
+            // the handle, so this is a single pass over the directory.
+            auto  *entries = (syscall_dir_entry_t*)buffer.start;
+            size_t count   = buffer.size / sizeof(syscall_dir_entry_t);
+            size_t i       = 0;
+            dir_entry_t entry;
+
+            for (; i < count; ++i) {
+                ssize_t n = Vfs::read_dir(args[1], entry);
+                if (n < 0 && i == 0) { ret = n; return; }
+                if (n <= 0) break;
+
+                copy_dir_entry(entries[i], entry);
+            }
+
+            ret = i;
+
+        } else if (args[0] == SYS_STAT) {
+
+            // (path*, path_len, stat*) => err
+
+            Memory::region_t path_ { args[1], args[2] };
+            Memory::region_t stat  { args[3], sizeof(syscall_stat_t) };
+
+            if (!is_buffer_valid(path_, max_path_length)
+             || !is_buffer_valid(stat)
+             || (stat.start & (alignof(syscall_stat_t)-1))) {
+                ret = ERR_invalid; return;
+            }
+
+            path_t  path = StringView((const char*)path_.start, path_.size);
+            inode_t inode;
+
+            ret = Vfs::stat(path, inode);
+            if ((s32)ret >= 0)
+                copy_stat(*(syscall_stat_t*)stat.start, inode);
+
+        } else if (args[0] == SYS_FSTAT) {
+
+            // (fd, stat*) => err
+
+            Memory::region_t stat { args[2], sizeof(syscall_stat_t) };
+
+            if (!is_buffer_valid(stat)
+             || (stat.start & (alignof(syscall_stat_t)-1))) {
+                ret = ERR_invalid; return;
+            }
+
+            inode_t inode;
+
+            ret = Vfs::fstat(args[1], inode);
+            if ((s32)ret >= 0)
+                copy_stat(*(syscall_stat_t*)stat.start, inode);
 
         } else if (args[0] == SYS_SEEK) {
 
@@ -311,7 +426,10 @@ namespace Interrupt::Syscall {
             Process::proc_t *proc;
             errno_t err = Elf::load_elf(path, arg_strs, proc);
 
-            // The remaining part of this system call will not yield.
+            // The new process is runnable now, but must not run before its
+            // handles are transplanted. load_elf() closes its file before it
+            // creates the process, and nothing below blocks or reaches a
+            // preempt_point() until the transplant is done.
             // Unlock the handles.
             for (fd_t fd : fd_transplant) {
                 if (fd < 0) continue;
@@ -332,7 +450,9 @@ namespace Interrupt::Syscall {
                 }
             }
 
-            ret = err;
+            // A failed transplant only leaves a handle closed in the child,
+            // so the spawn itself still succeeded.
+            ret = proc->id;
             if (spec.do_wait)
                 wait(proc->exit_sem);
 
@@ -345,6 +465,12 @@ namespace Interrupt::Syscall {
                 ret = ERR_not_exists;
                 return;
             }
+            // Neither the kernel nor the caller itself will ever exit
+            // while we wait, so don't let the caller hang forever.
+            if (tgt->id == 0 || tgt == Process::current_proc()) {
+                ret = ERR_invalid;
+                return;
+            }
             wait(tgt->exit_sem);
 
         } else if (args[0] == SYS_GET_CWD) {
@@ -402,9 +528,357 @@ namespace Interrupt::Syscall {
             ret = Vfs::make_pipe(((fd_t*)args[1])[0]
                                 ,((fd_t*)args[1])[1]);
 
+        } else if (args[0] == SYS_THREAD_CREATE) {
+
+            // (entrypoint, stack_top, eax, ebx) => tid
+
+            // The stack is provided by the caller. We only check that both
+            // addresses point into user memory: If they are bogus, the new
+            // thread will simply fault.
+            if (!addr_in_region(args[1], Memory::Layout::user())
+             || !addr_in_region(args[2] - 1, Memory::Layout::user())) {
+                ret = ERR_invalid; return;
+            }
+
+            Process::thread_t *t
+                = Process::make_user_thread(*Process::current_proc()
+                                           ,args[1]
+                                           ,args[2]
+                                           ,args[3]
+                                           ,args[4]);
+
+            ret = t ? t->id : ERR_nomem;
+
+        } else if (args[0] == SYS_FUTEX_WAIT) {
+
+            // (addr*, expected) => err
+
+            if ((args[1] & 3)
+             || !is_buffer_valid(Memory::region_t { args[1], sizeof(u32) })) {
+                ret = ERR_invalid; return;
+            }
+
+            ret = Futex::wait(args[1], args[2]);
+
+        } else if (args[0] == SYS_FUTEX_WAKE) {
+
+            // (addr*, count) => woken
+
+            if (args[1] & 3) {
+                ret = ERR_invalid; return;
+            }
+
+            ret = Futex::wake(args[1], args[2]);
+
+        } else if (args[0] == SYS_PORT_CREATE || args[0] == SYS_PORT_LOOKUP) {
+
+            // (name*, name_len) => port
+
+            Memory::region_t name_ { args[1], args[2] };
+            if (name_.size && !is_buffer_valid(name_, max_port_name)) {
+                ret = ERR_invalid; return;
+            }
+            String<max_port_name> name = StringView((const char*)name_.start, name_.size);
+
+            if (args[0] == SYS_PORT_CREATE)
+                 ret = Port::create(name);
+            else ret = Port::lookup(name);
+
+        } else if (args[0] == SYS_PORT_DESTROY) {
+
+            // (port) => err
+
+            ret = Port::destroy(args[1]);
+
+        } else if (args[0] == SYS_PORT_SEND || args[0] == SYS_PORT_CALL) {
+
+            // (port, msg*, reply*) => err
+
+            if (!is_buffer_valid(Memory::region_t { args[2], sizeof(syscall_message_t) })) {
+                ret = ERR_invalid; return;
+            }
+            syscall_message_t msg = *(syscall_message_t*)args[2];
+            if (!is_message_valid(msg)) {
+                ret = ERR_invalid; return;
+            }
+
+            if (args[0] == SYS_PORT_SEND) {
+                ret = Port::send(args[1], msg);
+                return;
+            }
+
+            if (!is_buffer_valid(Memory::region_t { args[3], sizeof(syscall_message_t) })) {
+                ret = ERR_invalid; return;
+            }
+            syscall_message_t reply = *(syscall_message_t*)args[3];
+            reply.size = min(reply.size, ipc_inline_max);
+            if (!is_message_valid(reply)) {
+                ret = ERR_invalid; return;
+            }
+
+            ret = Port::call(args[1], msg, reply);
+            *(syscall_message_t*)args[3] = reply;
+
+        } else if (args[0] == SYS_PORT_RECEIVE) {
+
+            // (port, msg*) => err
+
+            if (!is_buffer_valid(Memory::region_t { args[2], sizeof(syscall_message_t) })) {
+                ret = ERR_invalid; return;
+            }
+            syscall_message_t msg = *(syscall_message_t*)args[2];
+            msg.size = min(msg.size, ipc_inline_max);
+            if (!is_message_valid(msg)) {
+                ret = ERR_invalid; return;
+            }
+
+            ret = Port::receive(args[1], msg);
+            *(syscall_message_t*)args[2] = msg;
+
+        } else if (args[0] == SYS_PORT_REPLY) {
+
+            // (call id, msg*) => err
+
+            if (!is_buffer_valid(Memory::region_t { args[2], sizeof(syscall_message_t) })) {
+                ret = ERR_invalid; return;
+            }
+            syscall_message_t msg = *(syscall_message_t*)args[2];
+            if (!is_message_valid(msg)) {
+                ret = ERR_invalid; return;
+            }
+
+            ret = Port::reply(args[1], msg);
+
+        } else if (args[0] == SYS_POLL) {
+
+            // (fds*, count, timeout_ms) => ready count
+
+            size_t count = args[2];
+            if (count > max_proc_files
+             || !is_buffer_valid(Memory::region_t { args[1], count * sizeof(syscall_poll_fd_t) })) {
+                ret = ERR_invalid; return;
+            }
+
+            Array<syscall_poll_fd_t, max_proc_files> fds;
+            for (size_t i : range(count))
+                fds[i] = ((syscall_poll_fd_t*)args[1])[i];
+
+            ret = Poll::poll(fds.data(), count, (s32)args[3]);
+
+            for (size_t i : range(count))
+                ((syscall_poll_fd_t*)args[1])[i].revents = fds[i].revents;
+
+        } else if (args[0] == SYS_READV || args[0] == SYS_WRITEV) {
+
+            // (fd, iovec*, count) => bytes_transferred
+
+            size_t count = args[3];
+            if (count > max_iovecs
+             || !is_buffer_valid(Memory::region_t { args[2], count * sizeof(syscall_iovec_t) })) {
+                ret = ERR_invalid; return;
+            }
+
+            // Copy the segment list first: The process may change it while
+            // we are blocked.
+            Array<syscall_iovec_t, max_iovecs> iov;
+            size_t total = 0;
+
+            for (size_t i : range(count)) {
+                iov[i] = ((syscall_iovec_t*)args[2])[i];
+
+                if ((iov[i].size && !is_buffer_valid(Memory::region_t { (addr_t)iov[i].data, iov[i].size }))
+                 || !safe_add(total, iov[i].size, total)
+                 || total > (size_t)intmax<ssize_t>::value) {
+                    ret = ERR_invalid; return;
+                }
+            }
+
+            ret = args[0] == SYS_READV
+                ? Vfs::readv (args[1], iov.data(), count)
+                : Vfs::writev(args[1], iov.data(), count);
+
+        } else if (args[0] == SYS_COPY_RANGE) {
+
+            // (fd_in, fd_out, len) => bytes_copied
+
+            ret = Vfs::copy_range(args[1], args[2], args[3]);
+
+        } else if (args[0] == SYS_SYNC) {
+
+            // () => err
+
+            ret = Vfs::sync();
+
+        } else if (args[0] == SYS_FSYNC) {
+
+            // (fd) => err
+
+            ret = Vfs::fsync(args[1]);
+
+        } else if (args[0] == SYS_RING_SETUP) {
+
+            // (ring*) => err
+
+            ret = IoRing::setup(args[1]);
+
+        } else if (args[0] == SYS_RING_ENTER) {
+
+            // (min_complete) => completions available
+
+            ret = IoRing::enter(args[1]);
+
         } else {
             kprint("syscalled! (eax = {})\n", args[0]);
             ret = ERR_invalid;
         }
     }
+
+    void handle_syscall(Interrupt::interrupt_frame_t &frame) {
+
+        u32 nr    = frame.regs.eax;
+        u64 start = asm_rdtsc();
+
+        execute(frame);
+
+        // (syscalls that do not return, such as thread_delete, are not recorded)
+        Stats::record(nr, asm_rdtsc() - start, (s32)frame.regs.eax < 0);
+    }
+
+    /**
+     * SYSENTER entry path.
+     *
+     * SYSENTER switches to the kernel stack set in the SYSENTER MSRs (the
+     * current thread's kernel stack, see Gdt::set_tss_stack), but saves no
+     * state at all: Not even the user-mode return address and stack pointer.
+     * The libsys stub therefore passes a pointer to a small frame on its
+     * stack in EBP:
+     *
+     *     ebp+0: return address
+     *     ebp+4: ECX
+     *     ebp+8: EDX
+     *
+     * (ECX and EDX are clobbered by SYSEXIT, which takes the user-mode stack
+     *  pointer and return address from them)
+     *
+     * The stub resumes at the return address with ESP at ebp+4, and pops the
+     * registers itself.
+     *
+     * We build a regular interrupt frame from this, so that the thread can
+     * block and be resumed by the scheduler (with an IRET) exactly as if it
+     * had used int 0xca. If the system call returns normally however, we skip
+     * the dispatcher and return using SYSEXIT.
+     */
+    static void handle_sysenter(Interrupt::interrupt_frame_t &frame) {
+
+        addr_t user_frame = frame.regs.ebp;
+
+        if (!is_buffer_valid(Memory::region_t { user_frame, 3 * sizeof(u32) })) {
+            // We have nowhere to return to.
+            kprint("\n*** VIOLATION (invalid sysenter frame @{08x})\n    by {}\n"
+                  ,user_frame
+                  ,*Process::current_thread());
+
+            Process::delete_thread(Process::current_thread());
+            UNREACHABLE
+        }
+
+        const u32 *saved = (const u32*)user_frame;
+
+        frame.sys.eip      = saved[0];
+        frame.regs.ecx     = saved[1];
+        frame.regs.edx     = saved[2];
+        frame.sys.user_esp = user_frame + sizeof(u32);
+
+        // SYSENTER cleared the interrupt flag.
+        frame.sys.eflags  |= 1 << 9;
+
+        // As in the common interrupt handler: The thread may be resumed from
+        // its saved frame if it blocks.
+        Process::save_frame(frame);
+
+        handle_syscall(Process::current_thread()->frame);
+
+        frame = Process::current_thread()->frame;
+    }
+
+    void init() {
+        u32 eax = 1, ebx, ecx, edx;
+        asm volatile ("cpuid"
+                     :"+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+
+        u32 family   = (eax >> 8) & 0xf;
+        u32 model    = (eax >> 4) & 0xf;
+        u32 stepping =  eax       & 0xf;
+
+        // Early Pentium Pros report SEP, but do not actually support it.
+        bool have_sep = (edx & (1 << 11))
+                     && !(family == 6 && model < 3 && stepping < 3);
+
+        if (!have_sep) {
+            klog("syscall: no SYSENTER support, using int 0xca only\n");
+            return;
+        }
+
+        Memory::Gdt::enable_sysenter((addr_t)sysenter_entry);
+    }
+}
+
+extern "C" void sysenter_handler(Interrupt::interrupt_frame_t &frame);
+extern "C" void sysenter_handler(Interrupt::interrupt_frame_t &frame) {
+    Interrupt::Syscall::handle_sysenter(frame);
+}
+
+/**
+ * SYSENTER entrypoint.
+ *
+ * Saves state in the same layout as isr_common does for int 0xca, and
+ * returns to user-mode using SYSEXIT.
+ */
+extern "C" [[gnu::naked]] void sysenter_entry() {
+    asm ("/* Fake the CPU part of the interrupt frame */   \
+       \n push %0      /* user_ss  */                       \
+       \n push %%ebp   /* user_esp (fixed up later) */      \
+       \n pushf        /* eflags   */                       \
+       \n push %1      /* cs       */                       \
+       \n push $0      /* eip (fixed up later) */           \
+       \n push $0      /* error code */                     \
+       \n push $0xca   /* int_no   */                       \
+       \n /* Save state */                                  \
+       \n pusha                                             \
+       \n push %%ds                                         \
+       \n push %%es                                         \
+       \n push %%fs                                         \
+       \n push %%gs                                         \
+       \n push %%ss                                         \
+       \n /* Set kernel data segment */                     \
+       \n mov %2, %%eax                                     \
+       \n mov %%eax, %%ds                                   \
+       \n mov %%eax, %%es                                   \
+       \n cld                                               \
+       \n /* Push address of registers struct */            \
+       \n push %%esp                                        \
+       \n call sysenter_handler                             \
+       \n add $4, %%esp                                     \
+       \n /* Restore state (skip ss, we are already on it) */ \
+       \n add $4, %%esp                                     \
+       \n pop %%gs                                          \
+       \n pop %%fs                                          \
+       \n pop %%es                                          \
+       \n pop %%ds                                          \
+       \n popa                                              \
+       \n /* Pop error code and interrupt number. */        \
+       \n add $8, %%esp                                     \
+       \n /* SYSEXIT takes EIP from EDX, ESP from ECX */    \
+       \n pop %%edx                                         \
+       \n add $4, %%esp                                     \
+       \n /* Keep interrupts disabled until SYSEXIT */      \
+       \n btrl $9, (%%esp)                                  \
+       \n popf                                              \
+       \n pop %%ecx                                         \
+       \n /* (STI takes effect after the next instruction) */ \
+       \n sti                                               \
+       \n sysexit"
+       ::"i" (Memory::Gdt::i_user_data*8 | 3)
+        ,"i" (Memory::Gdt::i_user_code*8 | 3)
+        ,"i" (Memory::Gdt::i_kernel_data*8));
 }
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "frame.hh"
+#include "memory/region.hh"
 
 namespace Interrupt::Syscall {
 
@@ -28,4 +29,19 @@ namespace Interrupt::Syscall {
      * Return values <0 indicate an error condition.
      */
     void handle_syscall(Interrupt::interrupt_frame_t &frame);
+
+    /**
+     * Verify that a user-provided buffer is valid.
+     *
+     * A buffer syscall argument must lie completely within user memory,
+     * and must be mapped (resident) in its entirety.
+     */
+    bool is_buffer_valid(Memory::region_t region);
+
+    /**
+     * Enable the SYSENTER system call entry path, if the CPU supports it.
+     *
+     * `int 0xca` remains available regardless.
+     */
+    void init();
 }
@@ -0,0 +1,117 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "futex.hh"
+#include "semaphore.hh"
+#include "process/proc.hh"
+
+namespace Futex {
+
+    using namespace Process;
+
+    /// A wait queue for a single futex word.
+    struct futex_t {
+        proc_t     *proc = nullptr;
+        addr_t      addr = 0;
+        semaphore_t waiters { 0, {} }; ///< Never signalled without waiters, so i stays 0.
+        futex_t    *next = nullptr;    ///< Next futex in the same bucket.
+    };
+
+    /// Amount of hash buckets (must be a power of two).
+    static constexpr size_t bucket_count = 64;
+
+    static Array<futex_t*, bucket_count> buckets;
+
+    static size_t bucket(const proc_t *proc, addr_t addr) {
+        // Futex words are 4-byte aligned, drop the low bits.
+        return ((addr >> 2) ^ proc->id) & (bucket_count - 1);
+    }
+
+    static futex_t *find(proc_t *proc, addr_t addr) {
+        for (futex_t *f = buckets[bucket(proc, addr)]; f; f = f->next) {
+            if (f->proc == proc && f->addr == addr)
+                return f;
+        }
+        return nullptr;
+    }
+
+    static void remove(futex_t *f) {
+        for (futex_t **p = &buckets[bucket(f->proc, f->addr)]; *p; p = &(*p)->next) {
+            if (*p == f) {
+                *p = f->next;
+                break;
+            }
+        }
+        delete f;
+    }
+
+    errno_t wait(addr_t addr, u32 expected) {
+
+        // Interrupts are disabled, so the value cannot change between this
+        // check and going to sleep.
+        if (*(const u32*)addr != expected)
+            return ERR_again;
+
+        proc_t  *proc = current_proc();
+        futex_t *f    = find(proc, addr);
+
+        if (!f) {
+            f = new futex_t;
+            if (!f) return ERR_nomem;
+
+            f->proc = proc;
+            f->addr = addr;
+            f->next = buckets[bucket(proc, addr)];
+            buckets[bucket(proc, addr)] = f;
+        }
+
+        ::wait(f->waiters);
+
+        // Note: f may have been deleted by the waker at this point.
+
+        return ERR_success;
+    }
+
+    size_t wake(addr_t addr, size_t count) {
+
+        futex_t *f = find(current_proc(), addr);
+        if (!f) return 0;
+
+        size_t woken = 0;
+        while (woken < count && f->waiters.first_waiting) {
+            signal(f->waiters);
+            ++woken;
+        }
+
+        // Queues only live as long as they have waiters.
+        if (!f->waiters.first_waiting)
+            remove(f);
+
+        return woken;
+    }
+
+    void release(proc_t &proc) {
+        for (futex_t *&head : buckets) {
+            for (futex_t **p = &head; *p; ) {
+                if ((*p)->proc == &proc) {
+                    futex_t *f = *p;
+                    *p = f->next;
+                    delete f;
+                } else {
+                    p = &(*p)->next;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+
+namespace Process { struct proc_t; }
+
+/**
+ * Fast userspace mutex support.
+ *
+ * A futex is simply a 32-bit word in user memory. Userspace synchronisation
+ * primitives manipulate that word atomically and only enter the kernel when
+ * they need to sleep (wait) or need to wake up sleepers (wake).
+ *
+ * Wait queues are keyed on (process, user address) and only exist while
+ * threads are waiting on them.
+ */
+namespace Futex {
+
+    /**
+     * Block the current thread on the futex at `addr`, if the word at that
+     * address still contains `expected`.
+     *
+     * The address must have been validated by the caller.
+     *
+     * \return ERR_again if the value did not match, otherwise ERR_success
+     *         once woken up.
+     */
+    errno_t wait(addr_t addr, u32 expected);
+
+    /// Wake up at most `count` threads waiting on `addr`.
+    /// \return the amount of threads woken.
+    size_t wake(addr_t addr, size_t count);
+
+    /// Discard all wait queues of a process (on process deletion).
+    void release(Process::proc_t &proc);
+}
@@ -0,0 +1,219 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "io-ring.hh"
+#include "semaphore.hh"
+#include "process/proc.hh"
+#include "filesystem/vfs.hh"
+#include "interrupt/syscall.hh"
+
+namespace IoRing {
+
+    using namespace Process;
+
+    static_assert(sizeof(syscall_io_ring_t) == 2 * page_size, "I/O rings must be a page pair");
+
+    struct ring_t {
+        proc_t            *proc   = nullptr;
+        syscall_io_ring_t *shared = nullptr; ///< The ring, in process memory.
+        thread_t          *worker = nullptr;
+
+        bool sleeping = false; ///< The worker waits for a wakeup.
+        bool stopping = false; ///< The process is exiting.
+
+        // These are used as wait queues only: Their count stays 0.
+        semaphore_t work      { 0, {} }; ///< The worker sleeps here.
+        semaphore_t completed { 0, {} }; ///< Threads in enter() sleep here.
+    };
+
+    static void wake(semaphore_t &queue) {
+        if (queue.first_waiting)
+            signal_all(queue);
+    }
+
+    // Note: The process can modify the shared ring at any time, so any
+    // indices we read from it are treated as untrusted.
+
+    static u32 cq_used(const ring_t &ring) {
+        return ring.shared->cq.tail - ring.shared->cq.head;
+    }
+
+    static bool sq_empty(const ring_t &ring) {
+        return ring.shared->sq.head == ring.shared->sq.tail;
+    }
+
+    static bool cq_full(const ring_t &ring) {
+        return cq_used(ring) >= io_ring_cq_entries;
+    }
+
+    static bool is_buffer_valid(void *data, size_t size) {
+        // Zero-size transfers do not touch the buffer.
+        return !size
+            || Interrupt::Syscall::is_buffer_valid(Memory::region_t { (addr_t)data, size });
+    }
+
+    /// Execute a single submission entry.
+    static s32 execute(const syscall_io_sqe_t &e) {
+
+        switch (e.op) {
+        case io_op_nop:
+            return ERR_success;
+
+        case io_op_read:
+            if (!is_buffer_valid(e.data, e.size)) return ERR_invalid;
+            return Vfs::read(e.fd, e.data, e.size);
+
+        case io_op_write:
+            if (!is_buffer_valid(e.data, e.size)) return ERR_invalid;
+            return Vfs::write(e.fd, e.data, e.size);
+
+        case io_op_seek:
+            return Vfs::seek(e.fd, (seek_t)e.flags, e.offset);
+
+        case io_op_open: {
+            if (e.size > max_path_length || !is_buffer_valid(e.data, e.size))
+                return ERR_invalid;
+
+            // Copy the path: The process may change it while we open.
+            path_t path = StringView((const char*)e.data, e.size);
+            return Vfs::open(e.fd, path, e.flags);
+        }
+
+        case io_op_close:
+            return Vfs::close(e.fd);
+        }
+
+        return ERR_invalid;
+    }
+
+    static void worker(int arg) {
+
+        ring_t &ring = *(ring_t*)arg;
+
+        while (!ring.stopping) {
+
+            if (sq_empty(ring) || cq_full(ring)) {
+                // Nothing to do, or no room to post results: Sleep until
+                // the process enters the kernel.
+                ring.shared->sq.flags |= io_ring_need_wakeup;
+                ring.sleeping = true;
+
+                // Threads in enter() may be waiting for completions that
+                // will not come: Let them see that we went to sleep.
+                wake(ring.completed);
+
+                wait(ring.work);
+                continue;
+            }
+
+            u32 i = ring.shared->sq.head;
+
+            // Copy the entry, the process may modify it while we block.
+            syscall_io_sqe_t e = ring.shared->sq.entries[i % io_ring_sq_entries];
+
+            ring.shared->sq.head = i + 1;
+
+            s32 result = execute(e);
+
+            u32 t = ring.shared->cq.tail;
+            ring.shared->cq.entries[t % io_ring_cq_entries] = { e.user_data, result };
+            ring.shared->cq.tail = t + 1;
+
+            wake(ring.completed);
+
+            // Long batches should not hog the CPU.
+            preempt_point();
+        }
+
+        // The process is going away.
+        ring.proc->io_ring = nullptr;
+        delete &ring;
+
+        // (returning deletes this thread, and with it the process)
+    }
+
+    errno_t setup(addr_t addr) {
+
+        proc_t *proc = current_proc();
+
+        if (proc->io_ring)
+            return ERR_exists;
+
+        if (addr & (page_size - 1)
+         || !Interrupt::Syscall::is_buffer_valid(Memory::region_t { addr, sizeof(syscall_io_ring_t) }))
+            return ERR_invalid;
+
+        ring_t *ring = new ring_t;
+        if (!ring) return ERR_nomem;
+
+        ring->proc   = proc;
+        ring->shared = (syscall_io_ring_t*)addr;
+
+        ring->shared->sq.head  = 0;
+        ring->shared->sq.tail  = 0;
+        ring->shared->sq.flags = 0;
+        ring->shared->cq.head  = 0;
+        ring->shared->cq.tail  = 0;
+
+        ring->worker = make_kernel_thread(*proc, worker, "io-ring", (int)ring);
+        if (!ring->worker) {
+            delete ring;
+            return ERR_nomem;
+        }
+
+        proc->io_ring = ring;
+
+        return ERR_success;
+    }
+
+    ssize_t enter(size_t min_complete) {
+
+        ring_t *ring = current_proc()->io_ring;
+        if (!ring) return ERR_not_exists;
+
+        min_complete = min(min_complete, io_ring_cq_entries);
+
+        if (ring->sleeping) {
+            ring->sleeping = false;
+            ring->shared->sq.flags &= ~io_ring_need_wakeup;
+            wake(ring->work);
+        }
+
+        while (cq_used(*ring) < min_complete) {
+            // The worker cannot make progress if the process did not leave
+            // it anything to do.
+            if (ring->sleeping)
+                break;
+
+            wait(ring->completed);
+        }
+
+        return min(cq_used(*ring), io_ring_cq_entries);
+    }
+
+    void thread_exited(proc_t &proc) {
+
+        ring_t *ring = proc.io_ring;
+
+        // Is the worker the last thread standing?
+        for (thread_t *t = proc.first_thread; t; t = t->next_in_proc) {
+            if (t != ring->worker)
+                return;
+        }
+
+        ring->stopping = true;
+        ring->sleeping = false;
+        wake(ring->work);
+    }
+}
@@ -0,0 +1,64 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include <syscall-numbers.hh>
+
+namespace Process { struct proc_t; }
+
+/**
+ * Asynchronous I/O through shared submission/completion rings.
+ *
+ * A process registers two pages of its memory as a syscall_io_ring_t. It
+ * queues read, write, seek, open and close operations in the submission
+ * ring, and a kernel worker thread within the process executes them
+ * (through the regular Vfs functions) and posts the results to the
+ * completion ring.
+ *
+ * While the worker is busy, it picks up new submissions by itself: Only
+ * when it goes to sleep (io_ring_need_wakeup) does the process need to
+ * enter the kernel to have more submissions processed.
+ */
+namespace IoRing {
+
+    struct ring_t;
+
+    /**
+     * Register an I/O ring for the current process, and start its worker.
+     *
+     * `addr` must be page-aligned, and the ring must lie in mapped user
+     * memory. A process can have only one ring.
+     */
+    errno_t setup(addr_t addr);
+
+    /**
+     * Wake up the worker if needed, and wait until at least `min_complete`
+     * completions are available.
+     *
+     * \return the amount of available completions, or an error code below 0
+     */
+    ssize_t enter(size_t min_complete);
+
+    /**
+     * Called when a thread of a process with an I/O ring exits.
+     *
+     * Once only the worker remains, it is told to stop. This takes effect
+     * only when it finishes its current entry: A worker blocked inside an
+     * operation (e.g. reading a pipe that nobody writes to anymore) keeps
+     * the process alive until that operation returns.
+     */
+    void thread_exited(Process::proc_t &proc);
+}
@@ -0,0 +1,208 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "poll.hh"
+#include "semaphore.hh"
+#include "process/proc.hh"
+#include "filesystem/vfs.hh"
+#include "driver/timer/pit.hh"
+
+namespace Poll {
+
+    using namespace Process;
+
+    /// A thread blocked in poll().
+    struct poller_t {
+        semaphore_t wakeup    { 0, {} };
+        bool        woken     = false;
+        bool        timed_out = false;
+
+        Array<entry_t, max_proc_files> entries;
+        size_t                         entry_count = 0;
+
+        u64       deadline   = 0;
+        poller_t *next_timed = nullptr; ///< Next poller in the timeout list.
+    };
+
+    /// Pollers with a timeout, sorted by deadline.
+    static poller_t *timed = nullptr;
+
+    static void wake(poller_t &poller) {
+        if (!poller.woken) {
+            poller.woken = true;
+            signal(poller.wakeup);
+        }
+    }
+
+    void notify(waitq_t &queue) {
+        for (entry_t *e = queue.first; e; e = e->next)
+            wake(*e->poller);
+    }
+
+    void detach_queue(waitq_t &queue) {
+        // The pollers re-check their files after waking up, and will then
+        // find that this one is gone.
+        for (entry_t *e = queue.first; e; ) {
+            entry_t *next = e->next;
+            wake(*e->poller);
+            e->queue = nullptr;
+            e->prev  = nullptr;
+            e->next  = nullptr;
+            e = next;
+        }
+        queue.first = nullptr;
+    }
+
+    static void attach(poller_t &poller, waitq_t &queue) {
+        entry_t &e = poller.entries[poller.entry_count++];
+        e.poller = &poller;
+        e.queue  = &queue;
+        e.prev   = nullptr;
+        e.next   = queue.first;
+        if (queue.first) queue.first->prev = &e;
+        queue.first = &e;
+    }
+
+    static void detach_all(poller_t &poller) {
+        for (size_t i : range(poller.entry_count)) {
+            entry_t &e = poller.entries[i];
+            if (!e.queue) continue; // (the queue's owner is gone)
+            if (e.prev) e.prev->next    = e.next;
+            else        e.queue->first  = e.next;
+            if (e.next) e.next->prev    = e.prev;
+        }
+        poller.entry_count = 0;
+    }
+
+    static void add_timer(poller_t &poller, u64 deadline) {
+        poller.deadline = deadline;
+
+        poller_t **p = &timed;
+        while (*p && (*p)->deadline <= deadline)
+            p = &(*p)->next_timed;
+
+        poller.next_timed = *p;
+        *p = &poller;
+    }
+
+    static void remove_timer(poller_t &poller) {
+        for (poller_t **p = &timed; *p; p = &(*p)->next_timed) {
+            if (*p == &poller) {
+                *p = poller.next_timed;
+                break;
+            }
+        }
+    }
+
+    void timer_tick(u64 now_ms) {
+        while (timed && timed->deadline <= now_ms) {
+            poller_t *poller  = timed;
+            timed             = poller->next_timed;
+            poller->timed_out = true;
+            wake(*poller);
+        }
+    }
+
+    /// Check the readiness of all files, optionally attaching to their wait queues.
+    static size_t query(poller_t &poller, syscall_poll_fd_t *fds, size_t count, bool attach_queues) {
+        size_t ready = 0;
+
+        for (size_t i : range(count)) {
+            syscall_poll_fd_t &pfd = fds[i];
+
+            waitq_t *queue  = nullptr;
+            ssize_t  events = Vfs::poll(pfd.fd, queue);
+
+            if (events < 0)
+                 pfd.revents = poll_nval;
+            else pfd.revents = events & (pfd.events | poll_hup);
+
+            if (pfd.revents)
+                ++ready;
+
+            if (attach_queues && queue)
+                attach(poller, *queue);
+        }
+        return ready;
+    }
+
+    ssize_t poll(syscall_poll_fd_t *fds, size_t count, s32 timeout_ms) {
+
+        if (count > max_proc_files)
+            return ERR_invalid;
+
+        thread_t *t = current_thread();
+
+        poller_t poller;
+        poller.timed_out = timeout_ms == 0;
+
+        size_t ready = 0;
+
+        // Timeouts are in PIT ticks, which are milliseconds.
+        if (timeout_ms > 0)
+            add_timer(poller, Driver::Timer::Pit::ticks() + timeout_ms);
+
+        t->poller = &poller;
+
+        for (bool first = true; ; first = false) {
+            // Reset before checking: A notification that arrives after this
+            // point will make the wait below return immediately.
+            poller.woken = false;
+
+            ready = query(poller, fds, count, first);
+
+            if (ready || poller.timed_out)
+                break;
+
+            wait(poller.wakeup);
+        }
+
+        detach_all(poller);
+        remove_timer(poller);
+        t->poller = nullptr;
+
+        return ready;
+    }
+
+    bool sleep(waitq_t &queue, s32 timeout_ms) {
+
+        thread_t *t = current_thread();
+
+        poller_t poller;
+        poller.timed_out = timeout_ms == 0;
+
+        if (timeout_ms > 0)
+            add_timer(poller, Driver::Timer::Pit::ticks() + timeout_ms);
+
+        attach(poller, queue);
+        t->poller = &poller;
+
+        if (!poller.timed_out)
+            wait(poller.wakeup);
+
+        detach_all(poller);
+        remove_timer(poller);
+        t->poller = nullptr;
+
+        return !poller.timed_out;
+    }
+
+    void cancel(thread_t &t) {
+        if (t.poller) {
+            detach_all(*t.poller);
+            remove_timer(*t.poller);
+            t.poller = nullptr;
+        }
+    }
+}
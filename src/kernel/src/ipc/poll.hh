@@ -0,0 +1,84 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include <syscall-numbers.hh>
+
+namespace Process { struct thread_t; }
+
+/**
+ * Readiness multiplexing (poll).
+ *
+ * Every pollable object (a pipe, a device queue, ...) embeds a wait queue.
+ * A thread in poll() links an entry into the wait queue of each file it
+ * polls, and goes to sleep until any of those objects calls notify() on its
+ * queue, or until its timeout expires. It then re-checks the readiness of
+ * all files.
+ *
+ * Notifying an empty wait queue costs next to nothing, and notify() may be
+ * called from interrupt handlers.
+ */
+namespace Poll {
+
+    struct poller_t;
+    struct waitq_t;
+
+    /// Links a poller to one wait queue.
+    struct entry_t {
+        poller_t *poller = nullptr;
+        waitq_t  *queue  = nullptr;
+        entry_t  *prev   = nullptr;
+        entry_t  *next   = nullptr;
+    };
+
+    /// A wait queue, embedded in pollable objects.
+    struct waitq_t {
+        entry_t *first = nullptr;
+    };
+
+    /// Wake up all threads polling on the given queue.
+    void notify(waitq_t &queue);
+
+    /// Wake up and unlink all threads polling on the given queue
+    /// (must be called before the object embedding the queue is deleted).
+    void detach_queue(waitq_t &queue);
+
+    /**
+     * Wait until at least one of the given files is ready.
+     *
+     * \param timeout_ms  -1 waits indefinitely, 0 does not wait at all.
+     * \return the amount of files with non-zero revents.
+     */
+    ssize_t poll(syscall_poll_fd_t *fds, size_t count, s32 timeout_ms);
+
+    /**
+     * Sleep until the given queue is notified, or until the timeout expires.
+     *
+     * This lets kernel threads wait for work that must also be done
+     * periodically.
+     *
+     * \param timeout_ms  -1 waits indefinitely.
+     * \return true if the queue was notified, false on timeout.
+     */
+    bool sleep(waitq_t &queue, s32 timeout_ms);
+
+    /// Expire poll timeouts (called from the timer interrupt).
+    void timer_tick(u64 now_ms);
+
+    /// Detach a thread that is blocked in poll() (must be called before the
+    /// thread is deleted).
+    void cancel(Process::thread_t &t);
+}
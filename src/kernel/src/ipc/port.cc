@@ -0,0 +1,413 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "port.hh"
+#include "semaphore.hh"
+#include "process/proc.hh"
+#include "memory/manager-virtual.hh"
+
+namespace Port {
+
+    using namespace Process;
+
+    struct port_t;
+
+    /// A message in flight. Owned by the sending thread, which waits for `done`.
+    struct message_t {
+        u32       id            = 0;
+        proc_t   *sender        = nullptr;
+        thread_t *sender_thread = nullptr;
+        port_t   *port          = nullptr;
+
+        u32      tag        = 0;
+        u8      *data       = nullptr; ///< Kernel copy of the inline data.
+        size_t   size       = 0;
+        addr_t   pages      = 0;       ///< Payload, in the sender's address space.
+        size_t   pages_size = 0;
+
+        bool              is_call    = false;
+        syscall_message_t reply;             ///< Caller's reply buffers, then the reply.
+        u8               *reply_data = nullptr; ///< Kernel copy of the reply's inline data.
+
+        errno_t     result = ERR_success;
+        semaphore_t done { 0, {} };
+
+        message_t  *next = nullptr; ///< Next message in a port queue / pending call list.
+    };
+
+    struct port_t {
+        int                   id    = -1;
+        proc_t               *owner = nullptr;
+        String<max_port_name> name;
+
+        message_t *first = nullptr; ///< Queued messages, oldest first.
+        message_t *last  = nullptr;
+
+        semaphore_t messages  { 0, {} }; ///< Counts queued messages.
+        size_t      receivers = 0;       ///< Threads waiting in receive().
+        bool        dead      = false;
+    };
+
+    static Array<port_t*, max_ports> ports;
+
+    /// Calls that have been received, but not yet replied to.
+    static message_t *pending_calls = nullptr;
+
+    static u32 next_id = 1;
+
+    static port_t *get_port(int id) {
+        if (id < 0 || (size_t)id >= ports.size())
+            return nullptr;
+        return ports[id];
+    }
+
+    static void free_message(message_t *msg) {
+        if (msg->data)       delete[] msg->data;
+        if (msg->reply_data) delete[] msg->reply_data;
+        delete msg;
+    }
+
+    /// Wake up the sender of a message.
+    static void finish(message_t &msg, errno_t result) {
+        msg.result = result;
+        signal(msg.done);
+    }
+
+    static void push(port_t &port, message_t *msg) {
+        msg->next = nullptr;
+        if (port.last) port.last->next = msg;
+        else           port.first      = msg;
+        port.last = msg;
+    }
+
+    static message_t *pop(port_t &port) {
+        message_t *msg = port.first;
+        if (msg) {
+            port.first = msg->next;
+            if (!port.first) port.last = nullptr;
+            msg->next = nullptr;
+        }
+        return msg;
+    }
+
+    /// Unlink and free all messages in a list that were sent by thread `t`.
+    /// \return the amount of removed messages.
+    static size_t drop_messages(message_t *&list, thread_t &t) {
+        size_t dropped = 0;
+        for (message_t **p = &list; *p; ) {
+            if ((*p)->sender_thread == &t) {
+                message_t *msg = *p;
+                *p = msg->next;
+                free_message(msg);
+                ++dropped;
+            } else {
+                p = &(*p)->next;
+            }
+        }
+        return dropped;
+    }
+
+    /// Remove a port, failing all messages that are waiting on it.
+    static void kill_port(port_t *port, bool owner_gone) {
+
+        ports[port->id] = nullptr;
+        port->dead      = true;
+
+        while (message_t *msg = pop(*port))
+            finish(*msg, ERR_not_exists);
+
+        for (message_t **p = &pending_calls; *p; ) {
+            if ((*p)->port == port) {
+                message_t *msg = *p;
+                *p = msg->next;
+                finish(*msg, ERR_not_exists);
+            } else {
+                p = &(*p)->next;
+            }
+        }
+
+        if (port->receivers && !owner_gone) {
+            // The last receiver to wake up frees the port.
+            signal_all(port->messages);
+        } else {
+            delete port;
+        }
+    }
+
+    int create(StringView name) {
+
+        if (name.length() > max_port_name)
+            return ERR_invalid;
+
+        if (name.length() && lookup(name) >= 0)
+            return ERR_exists;
+
+        int id = ERR_limit;
+        for (auto [i, port] : enumerate(ports)) {
+            if (!port) {
+                id = i;
+                break;
+            }
+        }
+        if (id < 0) return id;
+
+        port_t *port = new port_t;
+        if (!port) return ERR_nomem;
+
+        port->id    = id;
+        port->owner = current_proc();
+        port->name  = name;
+
+        ports[id] = port;
+
+        return id;
+    }
+
+    errno_t destroy(int id) {
+        port_t *port = get_port(id);
+        if (!port)                         return ERR_not_exists;
+        if (port->owner != current_proc()) return ERR_perm;
+
+        kill_port(port, false);
+
+        return ERR_success;
+    }
+
+    int lookup(StringView name) {
+        if (!name.length())
+            return ERR_not_exists;
+
+        for (port_t *port : ports) {
+            if (port && port->name == name)
+                return port->id;
+        }
+        return ERR_not_exists;
+    }
+
+    /// Queue a message and wait until it is received (or replied to, for calls).
+    static errno_t transmit(int id, const syscall_message_t &m, syscall_message_t *reply) {
+
+        port_t *port = get_port(id);
+        if (!port) return ERR_not_exists;
+
+        if (m.size > ipc_inline_max) return ERR_limit;
+
+        message_t *msg = new message_t;
+        if (!msg) return ERR_nomem;
+
+        if (m.size) {
+            msg->data = new u8[m.size];
+            if (!msg->data) { delete msg; return ERR_nomem; }
+            memcpy(msg->data, m.data, m.size);
+        }
+
+        msg->id            = next_id++;
+        msg->sender        = current_proc();
+        msg->sender_thread = current_thread();
+        msg->port          = port;
+        msg->tag           = m.tag;
+        msg->size          = m.size;
+        msg->pages         = (addr_t)m.pages;
+        msg->pages_size    = m.pages_size;
+
+        if (!next_id) next_id = 1; // (0 means "not a call")
+
+        if (reply) {
+            msg->is_call = true;
+            msg->reply   = *reply;
+        }
+
+        push(*port, msg);
+        signal(port->messages);
+
+        wait(msg->done);
+
+        errno_t err = msg->result;
+
+        if (reply && err >= 0) {
+            // We are back in our own address space: Copy the reply data out.
+            if (msg->reply.size)
+                memcpy(reply->data, msg->reply_data, msg->reply.size);
+
+            reply->id         = 0;
+            reply->sender     = msg->reply.sender;
+            reply->tag        = msg->reply.tag;
+            reply->size       = msg->reply.size;
+            reply->pages_size = msg->reply.pages_size;
+        }
+
+        free_message(msg);
+
+        return err;
+    }
+
+    errno_t send(int id, const syscall_message_t &msg) {
+        return transmit(id, msg, nullptr);
+    }
+
+    errno_t call(int id, const syscall_message_t &msg, syscall_message_t &reply) {
+        return transmit(id, msg, &reply);
+    }
+
+    errno_t receive(int id, syscall_message_t &m) {
+
+        port_t *port = get_port(id);
+        if (!port)                         return ERR_not_exists;
+        if (port->owner != current_proc()) return ERR_perm;
+
+        message_t *msg = nullptr;
+
+        while (!msg) {
+            thread_t *t = current_thread();
+
+            port->receivers++;
+            t->receiving = port;
+            wait(port->messages);
+            t->receiving = nullptr;
+            port->receivers--;
+
+            if (port->dead) {
+                if (!port->receivers)
+                    delete port;
+                return ERR_not_exists;
+            }
+
+            // The message we were woken for may have been dropped since
+            // (see thread_exited): Then wait for the next one.
+            msg = pop(*port);
+        }
+
+        size_t n = min(m.size, msg->size);
+        if (n) memcpy(m.data, msg->data, n);
+
+        m.id     = msg->is_call ? msg->id : 0;
+        m.sender = msg->sender->id;
+        m.tag    = msg->tag;
+        m.size   = n;
+
+        errno_t err = ERR_success;
+
+        if (msg->pages_size) {
+            if (msg->pages_size > m.pages_size)
+                 err = ERR_nospace;
+            else err = Memory::Virtual::move_pages(*msg->sender->address_space
+                                                  ,msg->pages
+                                                  ,(addr_t)m.pages
+                                                  ,msg->pages_size
+                                                  ,Memory::Virtual::move_in);
+        }
+        m.pages_size = err >= 0 ? msg->pages_size : 0;
+
+        if (msg->is_call && err >= 0) {
+            // The caller keeps waiting until we reply.
+            msg->next     = pending_calls;
+            pending_calls = msg;
+        } else {
+            m.id = 0;
+            finish(*msg, err);
+        }
+
+        return err;
+    }
+
+    errno_t reply(u32 id, const syscall_message_t &m) {
+
+        proc_t    *proc = current_proc();
+        message_t *msg  = nullptr;
+
+        for (message_t **p = &pending_calls; *p; p = &(*p)->next) {
+            if ((*p)->id == id && (*p)->port->owner == proc) {
+                msg = *p;
+                *p  = msg->next;
+                break;
+            }
+        }
+        if (!msg) return ERR_not_exists;
+
+        // msg->reply describes the caller's buffers, and is filled with the reply.
+        syscall_message_t &r = msg->reply;
+
+        errno_t err = ERR_success;
+
+        // The caller copies the inline data into its own buffer once it wakes up.
+        size_t n = min(m.size, r.size);
+        if (n) {
+            msg->reply_data = new u8[n];
+            if (msg->reply_data)
+                 memcpy(msg->reply_data, m.data, n);
+            else err = ERR_nomem;
+        }
+
+        r.sender = proc->id;
+        r.tag    = m.tag;
+        r.size   = msg->reply_data ? n : 0;
+
+        if (err >= 0 && m.pages_size) {
+            if (m.pages_size > r.pages_size)
+                 err = ERR_nospace;
+            else err = Memory::Virtual::move_pages(*msg->sender->address_space
+                                                  ,(addr_t)r.pages
+                                                  ,(addr_t)m.pages
+                                                  ,m.pages_size
+                                                  ,Memory::Virtual::move_out);
+        }
+        r.pages_size = err >= 0 ? m.pages_size : 0;
+
+        finish(*msg, err);
+
+        return err;
+    }
+
+    void thread_exited(thread_t &t) {
+
+        if (port_t *port = t.receiving) {
+            t.receiving = nullptr;
+            port->receivers--;
+
+            if (port->dead) {
+                // The last receiver to go away frees the port.
+                if (!port->receivers)
+                    delete port;
+
+            } else if (!t.waiting_on) {
+                // We were woken up for a message, but will never pick it up:
+                // Pass the wakeup on to another receiver.
+                signal(port->messages);
+            }
+        }
+
+        // Nobody waits for the messages of this thread anymore.
+        for (port_t *port : ports) {
+            if (!port) continue;
+
+            size_t dropped = drop_messages(port->first, t);
+            while (dropped--)
+                try_wait(port->messages);
+
+            port->last = port->first;
+            while (port->last && port->last->next)
+                port->last = port->last->next;
+        }
+        drop_messages(pending_calls, t);
+    }
+
+    void release(proc_t &proc) {
+
+        // The process' threads are gone, and have dropped their messages.
+        for (port_t *port : ports) {
+            if (port && port->owner == &proc)
+                kill_port(port, true);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include <syscall-numbers.hh>
+
+namespace Process { struct proc_t; struct thread_t; }
+
+/**
+ * Message-passing IPC ports.
+ *
+ * A port is owned by the process that created it. Only that process may
+ * receive messages from it; any process may send messages to it, optionally
+ * after looking it up by name.
+ *
+ * Sending is synchronous: The sender blocks until a receiver has taken the
+ * message (send), or until the message has been replied to (call).
+ *
+ * Inline data is copied through a kernel buffer. Page-aligned payloads are
+ * not copied at all: The pages backing the sender's buffer are moved to the
+ * receiver's buffer, and the sender's buffer is left cleared (see
+ * Memory::Virtual::move_pages).
+ *
+ * All buffers in message structures must have been validated by the caller.
+ */
+namespace Port {
+
+    /// Create a port owned by the current process.
+    /// The name may be empty, in which case the port cannot be looked up.
+    /// \return the port ID, or an error code below 0.
+    int create(StringView name);
+
+    /// Destroy a port. Blocked senders fail with ERR_not_exists.
+    errno_t destroy(int port);
+
+    /// Find a port by name.
+    int lookup(StringView name);
+
+    /// Send a message and wait until it has been received.
+    errno_t send(int port, const syscall_message_t &msg);
+
+    /**
+     * Wait for a message on a port owned by the current process.
+     *
+     * On input, `msg` describes the receive buffers. On output, it describes
+     * the received message. Inline data that does not fit is discarded.
+     *
+     * \return ERR_nospace if the message had a page payload that could not
+     *         be transferred (the rest of the message is still delivered).
+     */
+    errno_t receive(int port, syscall_message_t &msg);
+
+    /// Send a message and wait for a reply, which is received into `reply`.
+    errno_t call(int port, const syscall_message_t &msg, syscall_message_t &reply);
+
+    /// Reply to a call received by the current process.
+    errno_t reply(u32 id, const syscall_message_t &msg);
+
+    /// Drop messages sent by a thread, and stop it from receiving (on thread deletion).
+    void thread_exited(Process::thread_t &t);
+
+    /// Destroy all ports of a process (on process deletion).
+    void release(Process::proc_t &proc);
+}
@@ -0,0 +1,95 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "rwlock.hh"
+#include "process/proc.hh"
+
+using namespace Process;
+
+// Note: Interrupts are disabled in kernel code, so the lock state cannot
+// change between checking it and going to sleep.
+
+/// Wake up a single thread waiting on a wait queue, if any.
+static void wake_one(semaphore_t &queue) {
+    if (queue.first_waiting)
+        signal(queue);
+}
+
+/// Hand a lock that was just released to whoever waits for it.
+static void wake_waiters(rwlock_t &lock) {
+    if (lock.writer)
+        return;
+
+    if (lock.writers_waiting) {
+        if (!lock.readers)
+            wake_one(lock.write_queue);
+    } else {
+        signal_all(lock.read_queue);
+    }
+}
+
+void read_lock(rwlock_t &lock) {
+    while (lock.writer || lock.writers_waiting)
+        wait(lock.read_queue);
+
+    lock.readers++;
+}
+
+void read_unlock(rwlock_t &lock) {
+    assert(lock.readers, "read_unlock on a lock without readers");
+
+    if (--lock.readers == 0)
+        wake_one(lock.write_queue);
+}
+
+void write_lock(rwlock_t &lock) {
+    if (lock.writer || lock.readers) {
+        thread_t *t = current_thread();
+
+        lock.writers_waiting++;
+        t->wants_write = &lock;
+        do {
+            wait(lock.write_queue);
+        } while (lock.writer || lock.readers);
+        t->wants_write = nullptr;
+        lock.writers_waiting--;
+    }
+
+    lock.writer = true;
+}
+
+void write_unlock(rwlock_t &lock) {
+    assert(lock.writer, "write_unlock on a lock without a writer");
+
+    lock.writer = false;
+
+    wake_waiters(lock);
+}
+
+void cancel_write_lock(thread_t &t) {
+    rwlock_t *lock = t.wants_write;
+    if (!lock) return;
+
+    t.wants_write = nullptr;
+    lock->writers_waiting--;
+
+    // The thread may have been woken up to take the lock, or it may have
+    // been the writer that readers were queued behind: Either way, others
+    // may now be able to proceed.
+    wake_waiters(*lock);
+}
+void wait_until_unlocked(rwlock_t &lock) {
+    write_lock(lock);
+    write_unlock(lock);
+}
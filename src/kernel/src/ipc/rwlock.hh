@@ -0,0 +1,74 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include "semaphore.hh"
+
+/**
+ * Reader-writer lock.
+ *
+ * Any amount of readers may hold the lock at the same time, while a writer
+ * holds it exclusively.
+ *
+ * Writers are preferred: Once a writer is waiting, new readers queue up
+ * behind it. This keeps a steady stream of readers from starving writers
+ * (at the cost of possibly starving readers under a steady stream of writers).
+ */
+struct rwlock_t {
+    size_t readers         = 0;     ///< Amount of readers holding the lock.
+    size_t writers_waiting = 0;     ///< Writers in write_lock(), queued or woken up.
+    bool   writer          = false; ///< Whether a writer holds the lock.
+
+    // These are used as wait queues only: Their count stays 0.
+    semaphore_t read_queue  { 0, {} };
+    semaphore_t write_queue { 0, {} };
+};
+
+void read_lock   (rwlock_t &lock); ///< Acquire shared access.
+void read_unlock (rwlock_t &lock);
+void write_lock  (rwlock_t &lock); ///< Acquire exclusive access.
+void write_unlock(rwlock_t &lock);
+
+/// Wait until the lock can be acquired exclusively.
+/// (it then stays free only until the caller blocks or reaches a preempt_point())
+void wait_until_unlocked(rwlock_t &lock);
+
+/// Withdraw a thread that is waiting in write_lock(), so that it does not
+/// hold up other threads (must be called when a waiting thread is deleted,
+/// after cancel_wait).
+void cancel_write_lock(Process::thread_t &t);
+
+/// Use RAII to automatically release a shared lock on scope exit.
+struct read_locked_within_scope {
+    rwlock_t &lock;
+
+    read_locked_within_scope(const read_locked_within_scope& ) = delete;
+    read_locked_within_scope(      read_locked_within_scope&&) = delete;
+
+     read_locked_within_scope(rwlock_t &l) : lock(l) { read_lock(lock);   }
+    ~read_locked_within_scope()                      { read_unlock(lock); }
+};
+
+/// Use RAII to automatically release an exclusive lock on scope exit.
+struct write_locked_within_scope {
+    rwlock_t &lock;
+
+    write_locked_within_scope(const write_locked_within_scope& ) = delete;
+    write_locked_within_scope(      write_locked_within_scope&&) = delete;
+
+     write_locked_within_scope(rwlock_t &l) : lock(l) { write_lock(lock);   }
+    ~write_locked_within_scope()                      { write_unlock(lock); }
+};
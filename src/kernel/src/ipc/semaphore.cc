@@ -20,18 +20,42 @@ using namespace Process;
 
 // Note: Interrupts are disabled in kernel code. This makes our lives easier.
 
-void signal(semaphore_t &sem) {
+/// Append a thread to the semaphore's wait list.
+static void push_waiter(semaphore_t &sem, thread_t &t) {
+    t.waiting_on   = &sem;
+    t.next_waiting = nullptr;
+    t.prev_waiting = sem.last_waiting;
+
+    if (sem.last_waiting) sem.last_waiting->next_waiting = &t;
+    else                  sem.first_waiting              = &t;
+
+    sem.last_waiting = &t;
+}
 
-    // Thread id and struct of the thread that we are unblocking.
-    tid_t     tid;
-    thread_t *thread = nullptr;
+/// Unlink a thread from the wait list it is on.
+static void remove_waiter(semaphore_t &sem, thread_t &t) {
+    if (t.prev_waiting) t.prev_waiting->next_waiting = t.next_waiting;
+    else                sem.first_waiting            = t.next_waiting;
+    if (t.next_waiting) t.next_waiting->prev_waiting = t.prev_waiting;
+    else                sem.last_waiting             = t.prev_waiting;
+
+    t.prev_waiting = nullptr;
+    t.next_waiting = nullptr;
+    t.waiting_on   = nullptr;
+}
+
+/// Remove the first thread from the semaphore's wait list.
+/// Returns null if nobody is waiting.
+static thread_t *pop_waiter(semaphore_t &sem) {
+    thread_t *t = sem.first_waiting;
+    if (t) remove_waiter(sem, *t);
+    return t;
+}
+
+void signal(semaphore_t &sem) {
 
     // Find a thread to unblock.
-    do {
-        if (!sem.waiting.dequeue(tid))
-            break;
-        thread = thread_by_tid(tid);
-    } while (!thread);
+    thread_t *thread = pop_waiter(sem);
 
     if (thread) {
         // Do we have a thread to unblock?
@@ -44,14 +68,8 @@ void signal(semaphore_t &sem) {
 
 void signal_all(semaphore_t &sem) {
 
-    tid_t     tid;
-    thread_t *thread = nullptr;
-
-    while (sem.waiting.dequeue(tid)) {
-        thread = thread_by_tid(tid);
-        if (thread)
-            unblock(*thread);
-    }
+    while (thread_t *thread = pop_waiter(sem))
+        unblock(*thread);
 }
 
 void wait(semaphore_t &sem) {
@@ -62,9 +80,7 @@ void wait(semaphore_t &sem) {
 
     } else {
         // We need to wait.
-        if (!sem.waiting.enqueue(current_thread()->id))
-            panic("semaphore waiting queue exceeded capacity while adding thread {}"
-                 ,*current_thread());
+        push_waiter(sem, *current_thread());
 
         block();
 
@@ -72,6 +88,11 @@ void wait(semaphore_t &sem) {
     }
 }
 
+void cancel_wait(thread_t &t) {
+    if (t.waiting_on)
+        remove_waiter(*t.waiting_on, t);
+}
+
 bool try_wait(semaphore_t &sem) {
 
     if (sem.i > 0) {
@@ -16,8 +16,7 @@
 
 #include "common.hh"
 
-// TODO: -> limits.hh
-static constexpr size_t semaphore_max_waiting = 32;
+namespace Process { struct thread_t; }
 
 struct semaphore_t;
 
@@ -26,16 +25,23 @@ void signal_all(semaphore_t &sem); ///< Increment until 0.
 void wait      (semaphore_t &sem); ///< Decrement or block.
 bool try_wait  (semaphore_t &sem); ///< Decrement or return false.
 
+/// Remove a thread from the wait list of the semaphore it is blocked on, if any.
+/// (must be called before a waiting thread is deleted)
+void cancel_wait(Process::thread_t &t);
+
 /**
  * Semaphore.
  *
- * (TODO: documentation)
+ * Waiting threads are linked into an intrusive FIFO list through their
+ * thread_t::prev_waiting / next_waiting pointers, so there is no limit on the
+ * amount of waiters and no allocation or lookup is needed to wait or signal.
  */
 struct semaphore_t {
 
     int i = 0;
 
-    Queue<tid_t, semaphore_max_waiting> waiting { };
+    Process::thread_t *first_waiting = nullptr; ///< Next thread to be woken up.
+    Process::thread_t  *last_waiting = nullptr; ///< Most recently added waiter.
 
     void signal()     {        ::signal    (*this); }
     void signal_all() {        ::signal_all(*this); }
@@ -0,0 +1,154 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include "semaphore.hh"
+#include "poll.hh"
+#include <os-std/atomic.hh>
+
+/**
+ * Lock-free single-producer / single-consumer ring buffer.
+ *
+ * Meant for handing data from an interrupt handler to a thread:
+ * Enqueueing never blocks (the item is dropped when the queue is full) and
+ * costs a single index store, plus one semaphore signal only when the
+ * consumer is asleep waiting for data.
+ *
+ * The producer only writes `tail`, the consumer only writes `head` and
+ * `sleeping`, so no locks are needed, even with multiple CPUs.
+ *
+ * Multiple producers are allowed as long as they cannot run concurrently
+ * (e.g. IRQ handlers on a single CPU, which run with interrupts disabled).
+ *
+ * Multiple consuming threads (e.g. two processes reading the same device)
+ * are serialized by `consumer_lock`, so that only one of them at a time
+ * touches `head` and `sleeping`, or waits on `wakeup`.
+ *
+ * N must be a power of two.
+ */
+template<typename T, size_t N>
+struct SpscQueue {
+
+    static_assert(N && !(N & (N - 1)), "SpscQueue size must be a power of two");
+
+    Array<T, N> items;
+
+    /// Free-running indices: `head` is the next item to read, `tail` is
+    /// where the next item is written. (they are wrapped when indexing items)
+    u32 head = 0;
+    u32 tail = 0;
+
+    /// Set by the consumer right before it goes to sleep.
+    u32 sleeping = 0;
+
+    /// Signalled by the producer to wake up a sleeping consumer.
+    semaphore_t wakeup { 0, {} };
+
+    /// Held by the (one) thread currently acting as the consumer.
+    mutex_t consumer_lock;
+
+    /// Threads polling for items.
+    Poll::waitq_t pollers;
+
+    constexpr size_t size() const { return N; }
+
+    size_t length() const {
+        u32 h, t;
+        atomic_load(head, h, __ATOMIC_ACQUIRE);
+        atomic_load(tail, t, __ATOMIC_ACQUIRE);
+        return t - h;
+    }
+
+    bool empty() const { return length() == 0; }
+
+    /// Add an item (producer side). Returns false if the queue is full.
+    bool try_enqueue(const T &item) {
+        u32 h, t;
+        atomic_load(head, h, __ATOMIC_ACQUIRE);
+        t = tail; // (we are the only writer)
+
+        if (t - h >= N)
+            return false;
+
+        items[t & (N - 1)] = item;
+        atomic_store(tail, t + 1, __ATOMIC_RELEASE);
+
+        // Only wake the consumer if it went to sleep.
+        if (atomic_exchange(sleeping, 0u))
+            signal(wakeup);
+
+        if (pollers.first)
+            Poll::notify(pollers);
+
+        return true;
+    }
+
+    /// Readiness for poll(): readable when items are available.
+    poll_events_t poll(Poll::waitq_t *&queue) {
+        queue = &pollers;
+        return empty() ? 0 : poll_in;
+    }
+
+private:
+    bool try_dequeue_(T &item) {
+        u32 h, t;
+        atomic_load(tail, t, __ATOMIC_ACQUIRE);
+        h = head; // (we are the only writer)
+
+        if (h == t)
+            return false;
+
+        item = items[h & (N - 1)];
+        atomic_store(head, h + 1, __ATOMIC_RELEASE);
+
+        return true;
+    }
+
+public:
+    /// Remove an item if one is available (consumer side).
+    /// Fails without blocking if another consumer holds the queue.
+    bool try_dequeue(T &item) {
+        if (!consumer_lock.try_lock())
+            return false;
+
+        bool ok = try_dequeue_(item);
+        consumer_lock.unlock();
+        return ok;
+    }
+
+    /// Remove an item, blocking until one is available (consumer side).
+    T dequeue() {
+        locked_within_scope _(consumer_lock);
+
+        T item;
+        while (!try_dequeue_(item)) {
+            atomic_store(sleeping, 1u);
+
+            // Re-check after announcing that we sleep: An item may have been
+            // added in between, without waking us.
+            if (!empty()) {
+                // If the producer already cleared the flag, it has signalled
+                // (or is about to signal) the semaphore: Consume that wakeup.
+                if (!atomic_exchange(sleeping, 0u))
+                    wait(wakeup);
+                continue;
+            }
+
+            wait(wakeup);
+        }
+        return item;
+    }
+};
@@ -21,7 +21,9 @@
 #include "driver/vga.hh"
 #include "ipc/semaphore.hh"
 #include "filesystem/vfs.hh"
+#include "filesystem/page-cache.hh"
 #include "process/elf.hh"
+#include "interrupt/syscall-stats.hh"
 
 /**
  * A built-in kernel shell for debugging purposes.
@@ -37,7 +39,7 @@ namespace Kshell {
      * read() for input). This means kshell may be usable when other parts of
      * the OS refuse to work.
      */
-    KQueue<char, 64> input;
+    SpscQueue<char, 64> input;
 
     static bool enabled_       = false;
     static bool input_enabled_ = false;
@@ -290,17 +292,11 @@ redo:
                 return;
             }
 
-            alignas(512) Array<char, 512> buffer;
             while (true) {
-                int n = Vfs::read(src, buffer);
+                ssize_t n = Vfs::copy_range(src, dst, 1_MiB);
                 if (n <= 0) {
                     if (n != 0)
-                        kprint("read failed: {}\n", error_name(n));
-                    break;
-                }
-                n = Vfs::write(dst, buffer.data(), n);
-                if (n < 0) {
-                    kprint("write failed: {}\n", error_name(n));
+                        kprint("copy failed: {}\n", error_name(n));
                     break;
                 }
             }
@@ -325,6 +321,7 @@ redo:
             // Correctly implementing shutdown in a cross-platform manner would
             // require us to implement APM or ACPI support, which is beyond our scope.
 
+            Vfs::sync();
             kprint("trying to initiate shutdown...\n");
 
             // source: https://wiki.osdev.org/Shutdown#Emulator-specific_methods
@@ -403,12 +400,15 @@ redo:
             kprint("\n  {-22} {}" , "mount"                , "print mountpoints"                     );
             kprint("\n  {-22} {}" , "open <r|w> <path>"    , "open a file (debug)"                   );
             kprint("\n  {-22} {}" , "opendir <path>"       , "open a directory (debug)"              );
+            kprint("\n  {-22} {}" , "pcache"               , "print page cache statistics"           );
             kprint("\n  {-22} {}" , "ps"                   , "print process information"             );
             kprint("\n  {-22} {}" , "psr"                  , "print ready queue"                     );
             kprint("\n  {-22} {}" , "put <path> <text>"    , "put text in file"                      );
             kprint("\n  {-22} {}" , "pwd"                  , "print working directory"               );
             kprint("\n  {-22} {}" , "reboot"               , "reboot the machine"                    );
             kprint("\n  {-22} {}" , "rm <path>..."         , "remove a file"                         );
+            kprint("\n  {-22} {}" , "sync"                 , "write modified file data to disk"      );
+            kprint("\n  {-22} {}" , "sysstat [reset]"      , "print (or reset) syscall statistics"   );
             kprint("\n  {-22} {}" , "tree [path]"          , "print a recursive directory listing"   );
             kprint("\n  {-22} {}" , "vgatest <w> <h>"      , "test video modes"                      );
             kprint("\n  {-22} {}" , "xd <path>..."         , "print a file in hexadecimal"           );
@@ -498,6 +498,8 @@ redo:
             } else {
                 kprint("usage: opendir <path>\n");
             }
+        } else if (s == "pcache") {
+            Vfs::PageCache::dump_stats();
         } else if (s == "ps") {
             Process::dump_all();
         } else if (s == "psr") {
@@ -536,9 +538,21 @@ redo:
                 kprint("usage: rm <path>...\n");
             }
         } else if (s == "reboot") {
+            Vfs::sync();
             kprint("\n** system reset **\n");
             // Io::wait(1_M);
             Io::out_8(0x64, 0xfe);
+        } else if (s == "sync") {
+            errno_t err = Vfs::sync();
+            if (err < 0)
+                kprint("sync failed: {}\n", error_name(err));
+        } else if (s == "sysstat") {
+            if (argc == 2 && argv[1] == "reset")
+                Interrupt::Syscall::Stats::reset();
+            else if (argc == 1)
+                Interrupt::Syscall::Stats::dump();
+            else
+                kprint("usage: sysstat [reset]\n");
         } else if (s == "tree") {
             if (argc == 2) {
                 tree(argv[1]);
@@ -15,7 +15,7 @@
 #pragma once
 
 #include "common.hh"
-#include "ipc/queue.hh"
+#include "ipc/spsc-queue.hh"
 
 /**
  * Kernel built-in debug shell.
@@ -30,7 +30,7 @@
 namespace Kshell {
 
     /// Input characters. Read by kshell, written by the serial/uart driver.
-    extern KQueue<char, 64> input;
+    extern SpscQueue<char, 64> input;
 
     /// Pauses all userspace threads and enables the kernel shell on the serial port.
     /// (there is no disable - the shell can only be disabled using shell commands)
@@ -18,6 +18,8 @@
 #include "interrupt/interrupt.hh"
 #include "driver/driver.hh"
 #include "process/proc.hh"
+#include "process/sched-trace.hh"
+#include "interrupt/syscall-stats.hh"
 #include "ipc/semaphore.hh"
 #include "filesystem/filesystem.hh"
 #include "kshell.hh"
@@ -110,6 +112,8 @@ extern "C" void kmain(const boot_info_t &boot_info) {
     Memory    ::init(boot_info); // Set up segments, enable paging.
     Process   ::init();          // Initialise the scheduler.
     FileSystem::init();          // Initialise the virtual filesystem.
+    Process::Trace::init();      // Expose the scheduler trace buffer.
+    Interrupt::Syscall::Stats::init(); // Expose syscall statistics.
     Driver    ::init();          // Detect and initialise hardware.
 
     // Create kernel threads.
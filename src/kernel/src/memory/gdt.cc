@@ -72,9 +72,33 @@ namespace Memory::Gdt {
     /// A 48-bit datastructure that indicates the location and size of the table.
     static const u64 gdt_ptr = (u64)table.data() << 16 | (sizeof(table) - 1);
 
+    // SYSENTER model-specific registers.
+    static constexpr u32 msr_sysenter_cs  = 0x174;
+    static constexpr u32 msr_sysenter_esp = 0x175;
+    static constexpr u32 msr_sysenter_eip = 0x176;
+
+    static bool sysenter_enabled = false;
+
     void set_tss_stack(addr_t kernel_stack) {
         tss.ss0  = i_kernel_data*8;
         tss.esp0 = kernel_stack;
+
+        // SYSENTER does not consult the TSS, it has its own stack pointer.
+        if (sysenter_enabled)
+            asm_wrmsr(msr_sysenter_esp, kernel_stack);
+    }
+
+    void enable_sysenter(addr_t entry) {
+        static_assert(i_kernel_data == i_kernel_code + 1
+                   && i_user_code   == i_kernel_code + 2
+                   && i_user_data   == i_kernel_code + 3
+                     ,"SYSENTER/SYSEXIT require a fixed GDT layout");
+
+        asm_wrmsr(msr_sysenter_cs,  i_kernel_code*8);
+        asm_wrmsr(msr_sysenter_esp, tss.esp0);
+        asm_wrmsr(msr_sysenter_eip, entry);
+
+        sysenter_enabled = true;
     }
 
     void init() {
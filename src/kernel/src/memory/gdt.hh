@@ -32,8 +32,19 @@ namespace Memory::Gdt {
         i_tss,
     };
 
+    /// Set the stack the CPU switches to when entering kernel-mode
+    /// (through interrupts as well as SYSENTER).
     void set_tss_stack(addr_t esp);
 
+    /**
+     * Enable the SYSENTER instruction, entering the kernel at `entry`.
+     *
+     * SYSENTER/SYSEXIT derive their segments from the kernel code segment:
+     * The kernel data, user code and user data segments must directly follow
+     * it in the GDT (they do).
+     */
+    void enable_sysenter(addr_t entry);
+
     /// Initialises the Global Descriptor Table and loads it.
     void init();
 }
@@ -31,7 +31,11 @@ namespace Memory::Layout {
                                       ,0x30000000 - addr_t(&KERNEL_HEAP_START)}; }
 
     region_t kernel_mmio()   { return {0x30000000
-                                      ,0x3fc00000 - 0x30000000}; }
+                                      ,0x3fb00000 - 0x30000000}; }
 
-    region_t user_args()     { return {0x40000000, 1_MiB}; }
+    region_t kernel_window() { return {0x3fb00000, 1_MiB}; }
+
+    region_t user_args()     { return {0x40000000, 1_MiB - 4_KiB}; }
+
+    region_t user_kernel_data() { return {0x400ff000, 4_KiB}; }
 }
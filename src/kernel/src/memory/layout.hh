@@ -32,10 +32,14 @@
  *     │ Kernel heap         │
  *     ├─────────────────────┤ 0x3000'0000  - @ 768  MiB
  *     │ Memory mapped I/O   │
+ *     ├─────────────────────┤ 0x3fb0'0000  - @ 1019 MiB
+ *     │ Mapping windows     │
  *     ├─────────────────────┤ 0x3fc0'0000  - @ 1020 MiB
  *     │ Page tables (4M)    │
  *     ├─────────────────────┤ 0x4000'0000  - @ 1 GiB
  *     │ User program args   │
+ *     ├─────────────────────┤ 0x400f'f000
+ *     │ Kernel data (RO)    │
  *     ├─────────────────────┤ 0x4010'0000  - @ 1025 MiB
  *     │ User code + data    │
  *     │ User heap           │
@@ -55,5 +59,7 @@ namespace Memory::Layout {
     region_t kernel_image(); ///< The kernel binary (text+data, including bss).
     region_t kernel_heap();  ///< The global kernel heap.
     region_t kernel_mmio();  ///< Memory mapped I/O.
+    region_t kernel_window(); ///< Temporary mappings of other address spaces' memory.
     region_t   user_args();  ///< The process arguments.
+    region_t   user_kernel_data(); ///< The per-process kernel data page.
 }
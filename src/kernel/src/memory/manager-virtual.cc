@@ -17,6 +17,7 @@
 #include "kernel-heap.hh"
 #include "layout.hh"
 #include "interrupt/interrupt.hh"
+#include "ipc/semaphore.hh"
 
 namespace Memory::Virtual {
 
@@ -344,6 +345,185 @@ namespace Memory::Virtual {
         return true;
     }
 
+    /// The amount of temporary mapping windows. The last page of the window
+    /// region is used to inspect the page tables of other address spaces.
+    static constexpr size_t window_count = 15;
+
+    // (see Layout::kernel_window())
+    static_assert(window_count * window_size + page_size <= 1_MiB);
+
+    static Array<bool, window_count> window_used;
+    static semaphore_t               windows_free { window_count, {} };
+
+    /// Set a kernel page mapping directly: Kernel page tables are shared by
+    /// all address spaces, so this does not depend on the current one.
+    static void set_kernel_pte(addr_t virt, pte_t pte) {
+        kernel_tabs[addr_tab(virt)][addr_pagei(virt)] = pte;
+        invalidate(virt);
+    }
+
+    /// Look up the page table entry for `virt` in any address space.
+    static pte_t lookup_pte(address_space_t &space, addr_t virt) {
+
+        pde_t pde = (*space.pd)[addr_tab(virt)];
+        if (!(pde & flag_present)) return 0;
+
+        // Temporarily map the page table itself.
+        addr_t scratch = Layout::kernel_window().start + window_count * window_size;
+
+        set_kernel_pte(scratch, make_pte(pde_addr(pde), flag_present));
+        pte_t pte = (*(PageTab*)scratch)[addr_pagei(virt)];
+        set_kernel_pte(scratch, 0);
+
+        return pte;
+    }
+
+    errno_t map_window(address_space_t &space, addr_t virt, size_t size, window_t &window) {
+
+        addr_t first  = virt & ~0xfff;
+        size_t npages = div_ceil(size + addr_offset(virt), page_size);
+
+        if (!size || npages * page_size > window_size)
+            return ERR_invalid;
+
+        wait(windows_free);
+
+        size_t slot = 0;
+        while (window_used[slot])
+            ++slot;
+
+        addr_t base = Layout::kernel_window().start + slot * window_size;
+
+        for (size_t pn : range(npages)) {
+            pte_t pte = lookup_pte(space, first + pn*page_size);
+
+            if (!(pte & flag_present)) {
+                // Undo what we have mapped so far.
+                for (size_t i : range(pn))
+                    set_kernel_pte(base + i*page_size, 0);
+
+                signal(windows_free);
+                return ERR_invalid;
+            }
+
+            set_kernel_pte(base + pn*page_size
+                          ,make_pte(pte_addr(pte), flag_present | flag_writable));
+        }
+
+        window_used[slot] = true;
+
+        window.data = (u8*)base + addr_offset(virt);
+        window.slot = slot;
+
+        return ERR_success;
+    }
+
+    void unmap_window(window_t &window) {
+
+        addr_t base = Layout::kernel_window().start + window.slot * window_size;
+
+        for (size_t pn : range(window_size / page_size))
+            set_kernel_pte(base + pn*page_size, 0);
+
+        window_used[window.slot] = false;
+        window.data = nullptr;
+
+        signal(windows_free);
+    }
+
+    /// Whether a page may take part in a page move:
+    /// It must be a present, writable user page owned by the address space.
+    static bool is_exchangeable(addr_t virt) {
+        PageTab *tab = get_tab(virt);
+        if (!tab) return false;
+
+        pte_t pte = (*tab)[addr_pagei(virt)];
+        return (pte & (flag_present | flag_writable | flag_user))
+                   == (flag_present | flag_writable | flag_user)
+            && !(pte & (flag_borrowed | flag_locked));
+    }
+
+    errno_t move_pages(address_space_t  &other
+                      ,addr_t            other_virt
+                      ,addr_t            virt
+                      ,size_t            size
+                      ,move_direction_t  direction) {
+
+        if ((other_virt | virt | size) & (page_size - 1))
+            return ERR_invalid;
+
+        size_t npages = size / page_size;
+
+        PageDir &here = current_dir();
+
+        // Ranges within the same address space must not overlap.
+        if (other.pd == &here
+         && other_virt < virt + size
+         && virt       < other_virt + size)
+            return ERR_invalid;
+
+        // Check both ranges before changing anything, so that we never leave
+        // a move half-done.
+        for (size_t i : range(npages)) {
+            if (!is_exchangeable(virt + i*page_size))
+                return ERR_invalid;
+        }
+
+        switch_address_space(*other.pd);
+        for (size_t i : range(npages)) {
+            if (!is_exchangeable(other_virt + i*page_size)) {
+                switch_address_space(here);
+                return ERR_invalid;
+            }
+        }
+        switch_address_space(here);
+
+        // The pages are swapped, so the source ends up with the destination's
+        // old pages. These must be cleared: We do that while they are mapped
+        // here, before moving in, or after moving out.
+        if (direction == move_in)
+            memset((void*)virt, 0, size);
+
+        // Swap the physical addresses, keeping each side's page flags.
+        // We go in batches to limit the amount of address space switches.
+        constexpr size_t batch = 64;
+        Array<pte_t, batch> ours;
+        Array<pte_t, batch> theirs;
+
+        for (size_t done = 0; done < npages; ) {
+            size_t n = min(batch, npages - done);
+
+            for (size_t i : range(n)) {
+                addr_t a = virt + (done + i)*page_size;
+                ours[i]  = (*get_tab(a))[addr_pagei(a)];
+            }
+
+            switch_address_space(*other.pd);
+            for (size_t i : range(n)) {
+                addr_t a   = other_virt + (done + i)*page_size;
+                pte_t &pte = (*get_tab(a))[addr_pagei(a)];
+                theirs[i]  = pte;
+                pte        = make_pte(pte_addr(ours[i]), pte & 0xfff);
+                invalidate(a);
+            }
+            switch_address_space(here);
+
+            for (size_t i : range(n)) {
+                addr_t a   = virt + (done + i)*page_size;
+                pte_t &pte = (*get_tab(a))[addr_pagei(a)];
+                pte        = make_pte(pte_addr(theirs[i]), pte & 0xfff);
+                invalidate(a);
+            }
+
+            done += n;
+        }
+
+        if (direction == move_out)
+            memset((void*)virt, 0, size);
+
+        return ERR_success;
+    }
+
     address_space_t *make_address_space() {
         address_space_t *space = new address_space_t; if (!space) return nullptr;
         PageDir *pd_     = new_pdir(); if (!pd_)     { delete space; return nullptr; }
@@ -462,6 +642,7 @@ namespace Memory::Virtual {
         klog("    image:  {S}\n", Layout::kernel_image());
         klog("    heap:   {S}\n", Layout::kernel_heap());
         klog("    mmio:   {S}\n", Layout::kernel_mmio());
+        klog("    window: {S}\n", Layout::kernel_window());
         klog("    ptabs:  {S}\n", Layout::page_tables());
         klog("  user:     {S}\n", Layout::user());
 
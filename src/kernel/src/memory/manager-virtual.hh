@@ -139,10 +139,67 @@ namespace Memory::Virtual {
     /// the current address space. (returns 0 if not present)
     addr_t virtual_to_physical(void *virt);
 
+    /**
+     * \name Temporary mapping windows
+     *
+     * Allow the kernel to access memory of an address space other than the
+     * current one without switching to it: The physical pages behind a range
+     * of that address space are mapped into a window in kernel memory (which
+     * is present in every address space).
+     *
+     * There is a small amount of windows, and map_window() blocks until one
+     * is available: Do not hold on to a window for longer than needed.
+     *
+     *@{
+     */
+
+    /// The maximum size of a window (including the offset of its start within a page).
+    constexpr size_t window_size = 64_KiB;
+
+    struct window_t {
+        u8    *data = nullptr; ///< Kernel address of the requested memory.
+        size_t slot = 0;
+    };
+
+    /**
+     * Map [virt, virt+size) of an address space into a window.
+     *
+     * All pages in the range must be present.
+     */
+    errno_t map_window(address_space_t &space, addr_t virt, size_t size, window_t &window);
+
+    /// Remove a window mapping.
+    void unmap_window(window_t &window);
+    ///@}
+
     /// Switch to a different address space.
     void switch_address_space(address_space_t &space);
     void switch_address_space(PageDir &page_dir);
 
+    /// Direction of move_pages(), seen from the current address space.
+    enum move_direction_t {
+        move_in,  ///< From the other address space into the current one.
+        move_out, ///< From the current address space into the other one.
+    };
+
+    /**
+     * Move the physical pages behind a range of user memory to an equally
+     * sized range in another address space (or vice versa, see `direction`).
+     *
+     * No data is copied: The destination range takes over the source's
+     * pages. The source range gets the destination's old pages in return,
+     * cleared, so that no data leaks from the destination to the source.
+     * This is how large IPC payloads are transferred.
+     *
+     * All addresses and the size must be page-aligned, and all pages must be
+     * present, writable and owned by their address space (not borrowed).
+     */
+    errno_t move_pages(address_space_t  &other
+                      ,addr_t            other_virt
+                      ,addr_t            virt
+                      ,size_t            size
+                      ,move_direction_t  direction);
+
     /// Create a new address space.
     address_space_t *make_address_space();
 
@@ -16,6 +16,8 @@
 #include "filesystem/vfs.hh"
 #include "memory/manager-virtual.hh"
 #include "memory/layout.hh"
+#include "memory/kernel-heap.hh"
+#include "kernel-data.hh"
 
 namespace Elf {
 
@@ -118,7 +120,7 @@ namespace Elf {
         // C++ guarantees that these cleanup functions are run on scope exit.
         // (in the C world, this is typically achieved with goto statements)
         //
-        ON_RETURN(Vfs::close(fd));
+        ON_RETURN({ if (fd >= 0) Vfs::close(fd); });
 
         // Read the header.
         elf32_header_t header;
@@ -138,32 +140,20 @@ namespace Elf {
         // We need to create an address space for the new process and read
         // code+data from the ELF file into that address space.
         //
-        // We cannot easily do this while the current process (in which we
-        // called load_elf) its address space is active: We would need to
-        // create many temporary memory mappings within the kernel address
-        // space, which may also interfere with other processes' syscalls
-        // unless we apply locking.
-        //
-        // Switching to a new address space and then reading into it is also
-        // not desirable: A context switch may happen during a Vfs::read(), and
+        // Switching to the new address space and then reading into it is not
+        // an option: A context switch may happen during a Vfs::read(), and
         // once we are re-scheduled, we are no longer in the new address space.
         //
-        // Our approach then is to read each segment in chunks into a temporary
-        // buffer, and for each chunk switch to the new address space only
-        // temporarily to copy from the buffer to the destination.
-        // It's not very efficient, but it's safe and relatively simple to implement.
+        // Instead, we map the new address space's destination pages into a
+        // temporary mapping window in kernel memory (see Memory::Virtual),
+        // and read each segment straight into that window, chunk by chunk.
         //
-        // (alternatively, we could load the entire ELF into a global kernel
-        // buffer and copy everything in one go, but then we would need to
-        // apply locking and add a maximum ELF size limit)
+        // We only switch to the new address space briefly to create its
+        // mappings.
 
         // Keep track of the address space of the current process.
         Memory::Virtual::PageDir &old_dir = Memory::Virtual::current_dir();
 
-        // Note: This chunk must fit in the per-thread kernel stack.
-        static constexpr size_t max_chunk_size = 8_KiB;
-        Array<u8, max_chunk_size> chunk;
-
         // Create an address space for the new process.
         Memory::Virtual::address_space_t *space = Memory::Virtual::make_address_space();
         if (!space) return ERR_nomem;
@@ -229,38 +219,43 @@ namespace Elf {
                 Memory::Virtual::switch_address_space(old_dir);
             }
 
-            // Read and copy the segment in chunks.
+            // Read the segment in chunks, directly into its destination.
             while (file_bytes_copied < entry.size_file) {
 
+                addr_t dest    = mem.start + file_bytes_copied;
                 size_t to_copy = min(entry.size_file - file_bytes_copied
-                                    ,chunk.size());
+                                    ,Memory::Virtual::window_size - dest % page_size);
 
-                err = Vfs::read_all(fd, chunk.data(), to_copy);
+                Memory::Virtual::window_t window;
+                err = Memory::Virtual::map_window(*space, dest, to_copy, window);
                 if (err < 0) return err;
 
-                // Temporarily switch to the new address space.
-                {
-                    Memory::Virtual::switch_address_space(*pd);
-
-                    memcpy((u8*)mem.start + file_bytes_copied
-                          ,chunk.data()
-                          ,to_copy);
+                err = Vfs::read_all(fd, window.data, to_copy);
 
-                    Memory::Virtual::switch_address_space(old_dir);
-                }
+                Memory::Virtual::unmap_window(window);
+                if (err < 0) return err;
 
                 file_bytes_copied += to_copy;
+
+                Process::preempt_point();
             }
 
             // Zero the remaining memory portion, if any.
-            if (entry.size_mem > entry.size_file) {
-                Memory::Virtual::switch_address_space(*pd);
+            for (size_t zeroed = entry.size_file; zeroed < mem.size; ) {
 
-                memset((u8*)mem.start + entry.size_file
-                      ,0
-                      ,mem.size - entry.size_file);
+                addr_t dest    = mem.start + zeroed;
+                size_t to_zero = min(mem.size - zeroed
+                                    ,Memory::Virtual::window_size - dest % page_size);
 
-                Memory::Virtual::switch_address_space(old_dir);
+                Memory::Virtual::window_t window;
+                err = Memory::Virtual::map_window(*space, dest, to_zero, window);
+                if (err < 0) return err;
+
+                memset(window.data, 0, to_zero);
+
+                Memory::Virtual::unmap_window(window);
+
+                zeroed += to_zero;
             }
         }
 
@@ -296,16 +291,40 @@ namespace Elf {
             Memory::Virtual::switch_address_space(old_dir);
         }
 
+        // Map the kernel data page.
+        syscall_kernel_data_t *kernel_data;
+        {
+            Memory::Virtual::switch_address_space(*pd);
+            kernel_data = Process::KernelData::make();
+            Memory::Virtual::switch_address_space(old_dir);
+
+            if (!kernel_data) return err = ERR_nomem;
+        }
+
         // Memory::Virtual::swtch_address_space(*pd);
         // hex_dump((char*)0x40100000, 8_K);
         // Memory::Virtual::switch_address_space(old_dir);
 
+        // Close the file before the process is created: Closing takes the
+        // VFS lock and may block, and the caller relies on the new process
+        // not running before we return (see SYS_SPAWN).
+        Vfs::close(fd);
+        fd = -1;
+
         // Note: The process name (`path` here) may be longer than the max process name.
         // It is automatically truncated.
         proc = Process::make_proc(space
                                  ,(function_ptr<void()>)header.entry
                                  ,path);
 
+        if (!proc) {
+            Memory::Heap::free(kernel_data);
+            return err = ERR_nomem;
+        }
+
+        // make_proc does not yield, so the process has not run yet.
+        Process::KernelData::attach(*proc, kernel_data);
+
         return ERR_success;
     }
 }
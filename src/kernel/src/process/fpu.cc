@@ -0,0 +1,131 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fpu.hh"
+#include "proc.hh"
+#include "memory/kernel-heap.hh"
+
+namespace Process::Fpu {
+
+    // CR0 / CR4 bits.
+    static constexpr u32 cr0_mp         = 1 <<  1; ///< Monitor coprocessor (WAIT honours TS).
+    static constexpr u32 cr0_em         = 1 <<  2; ///< Emulate FPU (all FPU instructions trap).
+    static constexpr u32 cr0_ts         = 1 <<  3; ///< Task switched (next FPU instruction traps).
+    static constexpr u32 cr0_ne         = 1 <<  5; ///< Native FPU error reporting.
+    static constexpr u32 cr4_osfxsr     = 1 <<  9; ///< OS supports FXSAVE/FXRSTOR.
+    static constexpr u32 cr4_osxmmexcpt = 1 << 10; ///< OS handles SIMD exceptions (#XM).
+
+    /// Default MXCSR value: all SIMD exceptions masked.
+    static constexpr u32 mxcsr_default  = 0x1f80;
+
+    static bool available = false; ///< FPU and FXSAVE are usable.
+    static bool have_sse  = false;
+
+    /// Whether CR0.TS is currently set (avoids needless CR0 writes).
+    static bool ts_set = false;
+
+    /// The thread whose state currently lives in the FPU registers.
+    static thread_t *owner = nullptr;
+
+    static void set_ts(bool set) {
+        if (set == ts_set) return;
+        ts_set = set;
+        if (set) asm_cr0(asm_cr0() |  cr0_ts);
+        else     asm volatile ("clts");
+    }
+
+    void switch_to(thread_t &thread) {
+        if (!available) return;
+
+        set_ts(&thread != owner);
+    }
+
+    void release(thread_t &thread) {
+        if (owner == &thread)
+            owner = nullptr;
+
+        if (thread.fpu_state) {
+            Memory::Heap::free(thread.fpu_state);
+            thread.fpu_state = nullptr;
+        }
+    }
+
+    bool handle_trap(const Interrupt::interrupt_frame_t &frame) {
+
+        // The kernel must not use the FPU, let that be a panic.
+        if (!available || Interrupt::is_frame_in_kernel_mode(frame))
+            return false;
+
+        thread_t *t = current_thread();
+
+        set_ts(false);
+
+        if (owner == t)
+            return true;
+
+        if (owner)
+            asm volatile ("fxsave (%0)" :: "r" (owner->fpu_state) : "memory");
+
+        owner = nullptr;
+
+        if (t->fpu_state) {
+            asm volatile ("fxrstor (%0)" :: "r" (t->fpu_state) : "memory");
+        } else {
+            // First FPU use for this thread: Start out with a clean state.
+            t->fpu_state = (u8*)Memory::Heap::alloc(state_size, state_align);
+            if (!t->fpu_state) {
+                kprint("fpu: could not allocate state for {}\n", *t);
+                set_ts(true);
+                return false;
+            }
+
+            asm volatile ("fninit");
+            if (have_sse) {
+                u32 mxcsr = mxcsr_default;
+                asm volatile ("ldmxcsr %0" :: "m" (mxcsr));
+            }
+        }
+
+        owner = t;
+
+        return true;
+    }
+
+    void init() {
+        u32 eax = 1, ebx, ecx, edx;
+        asm volatile ("cpuid"
+                     :"+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+
+        bool have_fpu  = edx & (1 <<  0);
+        bool have_fxsr = edx & (1 << 24);
+        have_sse       = edx & (1 << 25);
+
+        if (!have_fpu || !have_fxsr) {
+            // Make every FPU instruction trap: Threads that use it are killed.
+            asm_cr0(asm_cr0() | cr0_em);
+            klog("fpu: no FPU/FXSR support, floating point disabled\n");
+            return;
+        }
+
+        asm_cr0((asm_cr0() & ~cr0_em) | cr0_mp | cr0_ne | cr0_ts);
+
+        u32 cr4 = asm_cr4() | cr4_osfxsr;
+        if (have_sse)
+            cr4 |= cr4_osxmmexcpt;
+        asm_cr4(cr4);
+
+        ts_set    = true;
+        available = true;
+    }
+}
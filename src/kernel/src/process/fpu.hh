@@ -0,0 +1,54 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include "interrupt/frame.hh"
+
+namespace Process { struct thread_t; }
+
+/**
+ * Lazy FPU/SSE context switching.
+ *
+ * The kernel itself never uses the FPU (it is compiled with -msoft-float), so
+ * only user threads need their x87/SSE state preserved.
+ *
+ * Saving and restoring the 512-byte FXSAVE area on every task switch is
+ * wasteful, since most threads never touch the FPU. Instead, we set CR0.TS
+ * whenever we dispatch a thread that does not currently own the FPU
+ * registers. The first FPU instruction of such a thread then raises a
+ * Device Not Available exception (#NM), at which point we save the previous
+ * owner's state and load that of the current thread.
+ *
+ * A thread's save area is allocated on its first FPU use, so threads that
+ * never use the FPU pay nothing.
+ */
+namespace Process::Fpu {
+
+    static constexpr size_t state_size  = 512;
+    static constexpr size_t state_align = 16;
+
+    /// Update CR0.TS for the thread that is about to be dispatched.
+    void switch_to(thread_t &thread);
+
+    /// Forget a thread's FPU state (to be called before it is deleted).
+    void release(thread_t &thread);
+
+    /// Handler for #NM exceptions. Returns false if the fault is fatal.
+    bool handle_trap(const Interrupt::interrupt_frame_t &frame);
+
+    /// Detects FXSR/SSE support and configures CR0 and CR4.
+    void init();
+}
@@ -0,0 +1,99 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "kernel-data.hh"
+#include "proc.hh"
+#include "memory/kernel-heap.hh"
+#include "memory/layout.hh"
+#include "driver/timer/pit.hh"
+
+namespace Process::KernelData {
+
+    /// TSC calibration is done over this many ticks, after skipping the first few.
+    static constexpr u64 calibration_start = 10;
+    static constexpr u64 calibration_ticks = 100;
+
+    static u64 calibration_tsc = 0;
+    static u32 tsc_per_tick    = 0;
+
+    /// TSC value at the most recent timer tick.
+    static u64 tick_tsc = 0;
+
+    syscall_kernel_data_t *make() {
+
+        static_assert(sizeof(syscall_kernel_data_t) <= page_size);
+
+        auto *data = (syscall_kernel_data_t*)Memory::Heap::alloc(page_size, page_size);
+        if (!data) return nullptr;
+
+        memset(data, 0, page_size);
+        data->tick_hz = Driver::Timer::Pit::tick_hz;
+
+        // Readable, but not writable from user-mode.
+        // The page is borrowed: It is owned by the kernel heap.
+        errno_t err = Memory::Virtual::map(Memory::Layout::user_kernel_data().start
+                                          ,Memory::Virtual::virtual_to_physical(data)
+                                          ,page_size
+                                          ,Memory::Virtual::flag_user
+                                          |Memory::Virtual::flag_borrowed);
+        if (err < 0) {
+            Memory::Heap::free(data);
+            return nullptr;
+        }
+
+        return data;
+    }
+
+    void attach(proc_t &proc, syscall_kernel_data_t *data) {
+        proc.kernel_data = data;
+        data->pid        = proc.id;
+        data->main_tid   = proc.first_thread->id;
+
+        update(proc);
+    }
+
+    void release(proc_t &proc) {
+        if (proc.kernel_data) {
+            Memory::Heap::free(proc.kernel_data);
+            proc.kernel_data = nullptr;
+        }
+    }
+
+    void update(proc_t &proc) {
+        syscall_kernel_data_t *data = proc.kernel_data;
+        if (!data) return;
+
+        // User threads cannot run while we are in the kernel, but they may
+        // have been interrupted halfway through reading: seq tells them to retry.
+        data->seq++;
+        data->ticks        = Driver::Timer::Pit::ticks();
+        data->tick_tsc     = tick_tsc;
+        data->tsc_per_tick = tsc_per_tick;
+    }
+
+    void timer_tick(u64 ticks) {
+
+        tick_tsc = asm_rdtsc();
+
+        if (!tsc_per_tick) {
+            if (ticks == calibration_start)
+                calibration_tsc = tick_tsc;
+            else if (ticks == calibration_start + calibration_ticks)
+                tsc_per_tick = (tick_tsc - calibration_tsc) / calibration_ticks;
+        }
+
+        if (proc_t *proc = current_proc())
+            update(*proc);
+    }
+}
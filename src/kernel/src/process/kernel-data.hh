@@ -0,0 +1,56 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include <syscall-numbers.hh>
+
+namespace Process { struct proc_t; }
+
+/**
+ * The per-process kernel data page (see syscall_kernel_data_t).
+ *
+ * Every user process gets a page, allocated from the kernel heap, that is
+ * mapped read-only at Layout::user_kernel_data() in its address space.
+ * The kernel writes to it through its heap address, so updates do not
+ * depend on which address space is active.
+ *
+ * Only the page of the running process is kept up to date: It is refreshed
+ * when one of the process' threads is dispatched, and on every timer tick.
+ */
+namespace Process::KernelData {
+
+    /**
+     * Allocate a data page and map it into the current address space.
+     *
+     * This is done while loading a program, before the process exists:
+     * Call attach() once it does.
+     *
+     * \return nullptr if out of memory
+     */
+    syscall_kernel_data_t *make();
+
+    /// Hand the page over to its process, and fill in the process' IDs.
+    void attach(proc_t &proc, syscall_kernel_data_t *data);
+
+    /// Free the data page of a process (its mapping is removed with its address space).
+    void release(proc_t &proc);
+
+    /// Update the time fields of a process' page.
+    void update(proc_t &proc);
+
+    /// Called by the timer on every tick.
+    void timer_tick(u64 ticks);
+}
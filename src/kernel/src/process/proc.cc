@@ -14,11 +14,19 @@
  */
 #include "proc.hh"
 #include "idle.hh"
+#include "sched-trace.hh"
+#include "fpu.hh"
+#include "kernel-data.hh"
 #include "interrupt/interrupt.hh"
 #include "interrupt/frame.hh"
 #include "memory/manager-virtual.hh"
 #include "memory/gdt.hh"
 #include "filesystem/vfs.hh"
+#include "ipc/futex.hh"
+#include "ipc/port.hh"
+#include "ipc/poll.hh"
+#include "ipc/io-ring.hh"
+#include "ipc/rwlock.hh"
 
 // Assembly functions that assist in saving and restoring register & stack
 // state for threads waiting in kernel-mode.
@@ -67,6 +75,12 @@ namespace Process {
     size_t thread_count  = 0;
     size_t process_count = 1; // (the kernel is PID 0)
 
+    /// Set when the timeslice expired while the current thread ran kernel code.
+    static bool need_resched = false;
+
+    /// Why the current thread is being switched away from (for tracing).
+    static sched_trace_reason_t switch_reason = sched_reason_preempt;
+
     static Interrupt::interrupt_frame_t &current_frame(thread_t &t) {
         return t.frame;
     }
@@ -80,36 +94,51 @@ namespace Process {
         return (current_frame(t).sys.cs & 0x3) == 0;
     }
 
-    /// (inefficiently) find a process by its PID.
-    proc_t   *process_by_pid(pid_t pid) {
-        for (proc_t *p = &kernel_proc
-            ;p
-            ;p = p->next) {
+    /// Amount of buckets in the PID and TID lookup tables (must be a power of two).
+    static constexpr size_t id_table_size = 128;
 
-            if (p->id == pid)
-                return p;
-        }
-        return nullptr;
-    }
+    /**
+     * Hash table mapping process or thread IDs to their structures.
+     *
+     * IDs are handed out sequentially, so simply masking off the low bits
+     * spreads them evenly over the buckets. Entries with the same bucket are
+     * chained through their next_by_id pointer.
+     */
+    template<typename T>
+    struct id_table_t {
+        Array<T*, id_table_size> buckets;
 
-    /// (inefficiently) find a thread by its TID.
-    thread_t *thread_by_tid(tid_t tid) {
+        static size_t bucket(s32 id) { return (u32)id & (id_table_size - 1); }
 
-        for (proc_t *p = &kernel_proc
-            ;p
-            ;p = p->next) {
+        void insert(T &x) {
+            x.next_by_id          = buckets[bucket(x.id)];
+            buckets[bucket(x.id)] = &x;
+        }
 
-            for (thread_t *t = p->first_thread
-                ;t
-                ;t = t->next_in_proc) {
+        void remove(T &x) {
+            for (T **p = &buckets[bucket(x.id)]; *p; p = &(*p)->next_by_id) {
+                if (*p == &x) {
+                    *p = x.next_by_id;
+                    break;
+                }
+            }
+            x.next_by_id = nullptr;
+        }
 
-                if (t->id == tid)
-                    return t;
+        T *find(s32 id) {
+            for (T *x = buckets[bucket(id)]; x; x = x->next_by_id) {
+                if (x->id == id)
+                    return x;
             }
+            return nullptr;
         }
+    };
 
-        return nullptr;
-    }
+    static id_table_t<proc_t>   procs_by_id;
+    static id_table_t<thread_t> threads_by_id;
+
+    proc_t   *process_by_pid(pid_t pid) { return   procs_by_id.find(pid); }
+    thread_t *thread_by_tid (tid_t tid) { return threads_by_id.find(tid); }
 
     /// Pop the next thread from the ready queue.
     /// If no such thread exists, returns null.
@@ -161,6 +190,8 @@ namespace Process {
         }
 
         t.blocked = false;
+
+        Trace::record(sched_ev_enqueue, sched_reason_none, t.id, t.proc->id);
     }
 
     /// Add a thread to the front of the ready queue.
@@ -209,17 +240,43 @@ namespace Process {
             // This thread lives in a different address space than the current
             // thread, se we switch to it first.
 
-            // Kernel threads are excluded - they are mapped in all address spaces.
-            if (!thread.is_kernel_thread)
+            // Threads of the kernel process are excluded - they are mapped in
+            // all address spaces. (kernel threads of a user process, such as
+            // I/O ring workers, do need to access process memory)
+            if (thread.proc != &kernel_proc)
                 Memory::Virtual::switch_address_space(*thread.proc->address_space);
         }
 
+        // The kernel data page is only updated for the running process, so
+        // bring it up to date.
+        KernelData::update(*thread.proc);
+
         thread_t *old_thread = current_thread_;
 
+        if (old_thread != &thread) {
+            if (old_thread)
+                Trace::record(sched_ev_switch_out
+                             ,old_thread->blocked ? sched_reason_block : switch_reason
+                             ,old_thread->id
+                             ,old_thread->proc->id
+                             ,thread.id);
+
+            Trace::record(sched_ev_switch_in
+                         ,sched_reason_none
+                         ,thread.id
+                         ,thread.proc->id
+                         ,old_thread ? old_thread->id : -1);
+        }
+        switch_reason = sched_reason_preempt;
+        need_resched  = false;
+
         // Update active thread.
         current_thread_ = &thread;
         current_thread_->ticks_running++;
 
+        // Make the thread trap on FPU use if its state is not loaded.
+        Fpu::switch_to(thread);
+
         if (old_thread
         && !old_thread->blocked
         &&  old_thread != &thread
@@ -233,6 +290,23 @@ namespace Process {
         // // Force-disable interrupts (for testing).
         // thread.frame.sys.eflags &= ~(1 << 9);
 
+        if (!thread.is_kernel_thread) {
+            // We are resuming or starting a user-mode thread.
+
+            // Make sure the thread can enter kernel-mode again by setting
+            // the thread's kernel stack in the TSS struct (and the SYSENTER
+            // MSR). On the next interrupt, the CPU will automatically switch
+            // to this stack.
+            // This must also be done for threads that were suspended in
+            // kernel code: They return to user-mode (by IRET or SYSEXIT)
+            // without passing through here again.
+            Memory::Gdt::set_tss_stack((addr_t)(thread.kernel_stack.data()
+                                               +thread.kernel_stack.size()));
+
+            // This is not needed for kernel-threads: The CPU will not
+            // switch stacks when priviliged code is interrupted.
+        }
+
         // Was the thread suspended using yield() or block() within kernel code?
 
         if (thread.suspended_in_kernel) {
@@ -248,25 +322,11 @@ namespace Process {
 
             UNREACHABLE
 
-        } else {
-            // NO: Hard mode: The thread must be resumed (or started) using an
-            // interrupt frame.
-
-            if (!is_thread_in_kernel_mode(thread)) {
-                // We are resuming or starting a user-mode thread.
-
-                // Make sure the thread can enter kernel-mode again by setting
-                // the thread's kernel stack in the TSS struct.
-                // On the next interrupt, the CPU will automatically switch to
-                // this stack.
-                Memory::Gdt::set_tss_stack((addr_t)(thread.kernel_stack.data()
-                                                   +thread.kernel_stack.size()));
-
-                // This is not needed for kernel-threads: The CPU will not
-                // switch stacks when priviliged code is interrupted.
-            }
         }
 
+        // NO: Hard mode: The thread must be resumed (or started) using an
+        // interrupt frame.
+
         // We will now decide where on the thread's kernel-mode stack we place
         // the interrupt frame, and then enter it using an IRET (return from
         // interrupt).
@@ -331,6 +391,8 @@ namespace Process {
     void unblock(thread_t &t) {
 
         if (t.blocked) {
+            Trace::record(sched_ev_wakeup, sched_reason_none, t.id, t.proc->id);
+
             // This thread probably has something important to do, so push it
             // to the front of the queue.
             enqueue_front(t);
@@ -339,6 +401,30 @@ namespace Process {
         // kprint("UNBLOCK {} == {}\n", t, t.frame);
     }
 
+    void timeslice_expired(const Interrupt::interrupt_frame_t &frame) {
+
+        if (Interrupt::is_frame_in_kernel_mode(frame) && current_thread_ != idle_thread) {
+            // We interrupted a preempt_point(): Let it yield on its own terms.
+            need_resched = true;
+        } else {
+            yield_noreturn();
+        }
+    }
+
+    void preempt_point() {
+
+        if (!current_thread_) return;
+
+        // Allow pending IRQs (most importantly, the timer) to fire.
+        // (sti takes effect after the next instruction)
+        asm_sti();
+        asm_nop();
+        asm_cli();
+
+        if (need_resched)
+            yield();
+    }
+
     [[noreturn]]
     static void dispatch_next_thread() {
 
@@ -397,8 +483,17 @@ namespace Process {
     }
 
     void save_frame(const Interrupt::interrupt_frame_t &frame) {
-        if (current_thread_)
-            current_thread_->frame = frame;
+        if (!current_thread_)
+            return;
+
+        // A user thread can only be interrupted in kernel mode within a
+        // preempt_point(). Its saved frame is that of the system call it is
+        // executing, which we must not overwrite.
+        if (!current_thread_->is_kernel_thread
+         && Interrupt::is_frame_in_kernel_mode(frame))
+            return;
+
+        current_thread_->frame = frame;
     }
 
     [[noreturn]]
@@ -407,7 +502,14 @@ namespace Process {
         // When this thread is resumed, make it return directly to the
         // interrupted code instead of returning to yield's caller.
 
-        if (block) current_thread_->blocked = true;
+        if (block) {
+            current_thread_->blocked = true;
+            Trace::record(sched_ev_block
+                         ,sched_reason_block
+                         ,current_thread_->id
+                         ,current_thread_->proc->id
+                         ,(u32)__builtin_return_address(0));
+        }
 
         dispatch_next_thread();
 
@@ -423,9 +525,17 @@ namespace Process {
             return;
         }
 
-        if (block) current_thread_->blocked = true;
+        if (block) {
+            current_thread_->blocked = true;
+            Trace::record(sched_ev_block
+                         ,sched_reason_block
+                         ,current_thread_->id
+                         ,current_thread_->proc->id
+                         ,(u32)__builtin_return_address(0));
+        }
 
         if (block || ready_first) {
+            switch_reason = sched_reason_yield;
             // Enter suspend.
             suspend_in_kernel();
             // We've been resumed
@@ -479,15 +589,21 @@ namespace Process {
     }
 
     thread_t *make_kernel_thread(function_ptr<void(int)> entrypoint, StringView name, int arg) {
+        thread_t *t = make_kernel_thread(kernel_proc, entrypoint, name, arg);
+        assert(t, "could not allocate kernel thread");
+        return t;
+    }
+
+    thread_t *make_kernel_thread(proc_t &proc, function_ptr<void(int)> entrypoint, StringView name, int arg) {
 
         klog("proc: spawning kernel thread '{}'\n", name);
 
         thread_t *t         = new thread_t;
-        assert(t, "could not allocate kernel thread");
+        if (!t) return nullptr;
 
         t->id               = generate_thread_id();
         t->name             = name;
-        t->proc             = &kernel_proc;
+        t->proc             = &proc;
         t->is_kernel_thread = true;
 
         memset(&t->frame, 0, sizeof(t->frame));
@@ -513,19 +629,21 @@ namespace Process {
         t->frame.regs.ecx   = (addr_t)t;
         t->frame.sys.eip    = (addr_t)threadpoline;
 
-        if (kernel_proc.last_thread) {
-            kernel_proc.last_thread->next_in_proc = t;
-            t->prev_in_proc = kernel_proc.last_thread;
-            kernel_proc.last_thread = t;
+        if (proc.last_thread) {
+            proc.last_thread->next_in_proc = t;
+            t->prev_in_proc = proc.last_thread;
+            proc.last_thread = t;
 
         } else {
-            kernel_proc.first_thread = t;
-            kernel_proc. last_thread = t;
+            proc.first_thread = t;
+            proc. last_thread = t;
         }
 
         t->started    = false;
         t->next_ready = nullptr;
 
+        threads_by_id.insert(*t);
+
         enqueue(*t);
 
         return t;
@@ -550,8 +668,15 @@ namespace Process {
             }
         }
 
+        // Drop wait queues of futexes in this process.
+        Futex::release(*proc);
+
+        // Destroy IPC ports of this process and drop messages it sent.
+        Port::release(*proc);
+
         // Free all process-owned memory.
         Memory::Virtual::delete_address_space(proc->address_space);
+        KernelData::release(*proc);
 
         // Update linked lists.
         if (proc->next) proc->next->prev = proc->prev;
@@ -559,6 +684,8 @@ namespace Process {
         if (proc == proc_first) proc_first = proc->next;
         if (proc == proc_last ) proc_last  = proc->prev;
 
+        procs_by_id.remove(*proc);
+
         delete proc;
     }
 
@@ -576,6 +703,8 @@ namespace Process {
             Vfs::wait_until_lockable();
         }
 
+        threads_by_id.remove(*t);
+
         // Update linked lists.
         if (t->proc->first_thread == t) t->proc->first_thread = t->next_in_proc;
         if (t->proc->last_thread  == t) t->proc->last_thread  = t->prev_in_proc;
@@ -587,9 +716,24 @@ namespace Process {
         if (ready_last  == t) ready_last  = t->prev_ready;
         if (ready_first == t) ready_first = t->next_ready;
 
+        // A thread may be killed while waiting for IPC messages (this must
+        // go before cancel_wait), on a semaphore, for a write lock, or in
+        // poll().
+        Port::thread_exited(*t);
+        cancel_wait(*t);
+        cancel_write_lock(*t);
+        Poll::cancel(*t);
+
+        // Stop the I/O ring worker once it is the only thread left, so that
+        // the process can go away.
+        if (t->proc->io_ring)
+            IoRing::thread_exited(*t->proc);
+
         if (t == current_thread_) {
             // We are deleting the currently running thread.
             // This is a bit more involved.
+            Trace::record(sched_ev_switch_out, sched_reason_exit, t->id, t->proc->id);
+
             delete_running_thread();
 
             UNREACHABLE
@@ -601,10 +745,68 @@ namespace Process {
                 // Delete an entire process.
                 delete_proc(t->proc);
 
+            Fpu::release(*t);
             delete t; // *poof*
         }
     }
 
+    /// Set up the initial state of a new user-mode thread.
+    static void init_user_thread(thread_t &t, proc_t &p, addr_t eip, addr_t esp) {
+
+        t.id                 = generate_thread_id();
+        t.proc               = &p;
+        t.is_kernel_thread   = false;
+
+        t.stack_bottom       = t.kernel_stack.data();
+
+        memset(&t.frame, 0, sizeof(t.frame));
+
+        t.frame.regs.esp     = (addr_t)(t.kernel_stack.data() + t.kernel_stack.size());
+
+        t.frame.sys.eflags   = (asm_eflags() & 0xffc0'802a) | 1 << 9; // enable interrupts.
+        t.frame.sys.cs       = Memory::Gdt::i_user_code  *8 + 3; // The '3' indicates Ring 3 - user mode.
+        t.frame.sys.user_ss  = Memory::Gdt::i_user_data  *8 + 3;
+        t.frame.sys.user_esp = esp;
+
+        t.frame.regs.ss      = Memory::Gdt::i_kernel_data*8;
+        t.frame.regs.ds      = Memory::Gdt::i_user_data  *8 + 3;
+        t.frame.regs.es      = Memory::Gdt::i_user_data  *8 + 3;
+        t.frame.regs.fs      = Memory::Gdt::i_user_data  *8 + 3;
+        t.frame.regs.gs      = Memory::Gdt::i_user_data  *8 + 3;
+
+        t.frame.sys.eip      = eip;
+    }
+
+    thread_t *make_user_thread(proc_t &proc
+                              ,addr_t  entrypoint
+                              ,addr_t  stack_top
+                              ,u32     eax
+                              ,u32     ebx) {
+
+        thread_t *t = new thread_t;
+        if (!t) return nullptr;
+
+        init_user_thread(*t, proc, entrypoint, stack_top);
+
+        t->frame.regs.eax = eax;
+        t->frame.regs.ebx = ebx;
+
+        // Add to the end of the process' thread list.
+        t->prev_in_proc = proc.last_thread;
+        if (proc.last_thread) proc.last_thread->next_in_proc = t;
+        else                  proc.first_thread              = t;
+        proc.last_thread = t;
+
+        t->started    = false;
+        t->next_ready = nullptr;
+
+        threads_by_id.insert(*t);
+
+        enqueue(*t);
+
+        return t;
+    }
+
     proc_t *make_proc(Memory::Virtual::address_space_t *address_space
                      ,function_ptr<void()> main_entrypoint
                      ,StringView name) {
@@ -622,29 +824,8 @@ namespace Process {
         p->first_thread = t;
         p->last_thread  = t;
 
-        t->id                 = generate_thread_id();
-        t->name               = "main";
-        t->proc               = p;
-        t->is_kernel_thread   = false;
-
-        t->stack_bottom       = t->kernel_stack.data();
-
-        memset(&t->frame, 0, sizeof(t->frame));
-
-        t->frame.regs.esp     = (addr_t)(t->kernel_stack.data() + t->kernel_stack.size());
-
-        t->frame.sys.eflags   = (asm_eflags() & 0xffc0'802a) | 1 << 9; // enable interrupts.
-        t->frame.sys.cs       = Memory::Gdt::i_user_code  *8 + 3; // The '3' indicates Ring 3 - user mode.
-        t->frame.sys.user_ss  = Memory::Gdt::i_user_data  *8 + 3;
-        t->frame.sys.user_esp = 0;
-
-        t->frame.regs.ss      = Memory::Gdt::i_kernel_data*8;
-        t->frame.regs.ds      = Memory::Gdt::i_user_data  *8 + 3;
-        t->frame.regs.es      = Memory::Gdt::i_user_data  *8 + 3;
-        t->frame.regs.fs      = Memory::Gdt::i_user_data  *8 + 3;
-        t->frame.regs.gs      = Memory::Gdt::i_user_data  *8 + 3;
-
-        t->frame.sys.eip      = (addr_t)main_entrypoint;
+        init_user_thread(*t, *p, (addr_t)main_entrypoint, 0);
+        t->name = "main";
 
         assert(proc_first && proc_last, "kernel proc missing");
         proc_last->next = p;
@@ -654,6 +835,9 @@ namespace Process {
         t->started    = false;
         t->next_ready = nullptr;
 
+          procs_by_id.insert(*p);
+        threads_by_id.insert(*t);
+
         p->working_directory = current_thread_->proc->working_directory;
 
         enqueue(*t);
@@ -733,6 +917,10 @@ namespace Process {
         proc_first = &kernel_proc;
         proc_last  = &kernel_proc;
 
+        procs_by_id.insert(kernel_proc);
+
+        Fpu::init();
+
         idle_thread = make_kernel_thread(idle, "idle");
     }
 }
@@ -811,6 +999,7 @@ void delete_running_thread_2() {
         delete_proc(Process::current_thread_->proc);
 
     // Actually delete thread resources.
+    Process::Fpu::release(*Process::current_thread_);
     delete Process::current_thread_;
     Process::current_thread_ = nullptr;
 
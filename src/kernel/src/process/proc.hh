@@ -43,6 +43,12 @@ static constexpr size_t per_thread_kernel_stack_size = 32_KiB;
  */
 
 struct file_handle_t;
+struct syscall_kernel_data_t;
+
+namespace Poll { struct poller_t; }
+namespace IoRing { struct ring_t; }
+namespace Port { struct port_t; }
+struct rwlock_t;
 
 namespace Process {
 
@@ -63,6 +69,16 @@ namespace Process {
         thread_t *next_in_proc   = nullptr; ///< Points to another thread within the same proc.
         thread_t *prev_ready     = nullptr; ///< Points to the previous thread in the ready queue.
         thread_t *next_ready     = nullptr; ///< Points to the next     thread in the ready queue.
+        thread_t *prev_waiting   = nullptr; ///< Points to the previous thread waiting on the same semaphore.
+        thread_t *next_waiting   = nullptr; ///< Points to the next     thread waiting on the same semaphore.
+
+        semaphore_t *waiting_on  = nullptr; ///< The semaphore this thread is blocked on, if any.
+        rwlock_t *wants_write    = nullptr; ///< Set while the thread waits in write_lock().
+
+        Poll::poller_t *poller   = nullptr; ///< Set while the thread is blocked in poll().
+        Port::port_t *receiving  = nullptr; ///< Set while the thread is in Port::receive().
+
+        thread_t *next_by_id     = nullptr; ///< Next thread in the same TID lookup table bucket.
 
         Interrupt::interrupt_frame_t frame; ///< Stores thread state when it's interrupted.
 
@@ -86,6 +102,10 @@ namespace Process {
          */
         Array<u32, per_thread_kernel_stack_size/sizeof(u32)> kernel_stack;
 
+        /// FXSAVE area for FPU/SSE state, allocated on first FPU use.
+        /// \see Process::Fpu
+        u8 *fpu_state            = nullptr;
+
         bool started             = false;   ///< Whether the thread was dispatched at least once.
         bool suspended_in_kernel = false;   ///< Whether the thread was suspended within kernel-mode.
         bool blocked             = false;   ///< Whether the thread is waiting on something.
@@ -104,6 +124,8 @@ namespace Process {
         proc_t *prev = nullptr;           ///< Points to a different process.
         proc_t *next = nullptr;           ///< Points to a different process.
 
+        proc_t *next_by_id = nullptr;     ///< Next process in the same PID lookup table bucket.
+
         String<max_proc_name> name;       ///< The name of this process (cannot be empty).
 
         Memory::Virtual::address_space_t *address_space; ///< The Process' memory mappings.
@@ -113,6 +135,12 @@ namespace Process {
 
         String<max_path_length> working_directory = "/";
 
+        IoRing::ring_t *io_ring = nullptr; ///< The process' I/O ring, if set up.
+
+        /// The process' kernel data page (kernel heap address), if any.
+        /// \see Process::KernelData
+        syscall_kernel_data_t *kernel_data = nullptr;
+
         int         exit_code = -1;
         semaphore_t exit_sem;
     };
@@ -120,8 +148,8 @@ namespace Process {
     thread_t *current_thread(); ///< Gets the currently running thread.
     proc_t   *current_proc();   ///< Gets the currently running process.
 
-    proc_t   *process_by_pid(pid_t pid); /// Find a process by its PID.
-    thread_t * thread_by_tid(tid_t tid); /// Find a thread  by its TID.
+    proc_t   *process_by_pid(pid_t pid); ///< Find a process by its PID.
+    thread_t * thread_by_tid(tid_t tid); ///< Find a thread  by its TID.
 
     // For the following functions, `block` indicates whether the current
     // thread should be added to the ready queue or not.
@@ -146,6 +174,27 @@ namespace Process {
     /// Unblocks a thread, adding it to the ready queue.
     void unblock(thread_t &t);
 
+    /**
+     * Called by the timer when the current thread's timeslice is used up.
+     *
+     * Threads interrupted in user mode (and the idle thread) are preempted
+     * immediately. Kernel code can only be interrupted within a
+     * preempt_point(), so in that case a reschedule is requested instead.
+     */
+    void timeslice_expired(const Interrupt::interrupt_frame_t &frame);
+
+    /**
+     * Preemption checkpoint for long-running kernel loops.
+     *
+     * Kernel code runs with interrupts disabled, so a thread doing lots of
+     * work in a system call would otherwise hog the CPU. This briefly lets
+     * pending interrupts in, and yields if the timeslice has expired.
+     *
+     * Must not be called while interrupts need to stay disabled (e.g. while
+     * manipulating scheduler or semaphore state).
+     */
+    void preempt_point();
+
     void dump_ready_queue();
     void dump_all();
 
@@ -170,6 +219,32 @@ namespace Process {
     thread_t *make_kernel_thread(function_ptr<void(   )> entrypoint, StringView name);
     ///@}
 
+    /**
+     * Create a kernel thread within a user process.
+     *
+     * The thread runs in kernel-mode, but in the address space and with the
+     * open files of `proc`. It keeps the process alive until it exits.
+     *
+     * \return nullptr if the thread could not be allocated.
+     */
+    thread_t *make_kernel_thread(proc_t &proc
+                                ,function_ptr<void(int)> entrypoint
+                                ,StringView name
+                                ,int arg = 0);
+
+    /**
+     * Create an additional user-mode thread within a process.
+     *
+     * The thread starts at `entrypoint` with the given (user) stack pointer.
+     * eax and ebx are passed to the thread in the respective registers, so
+     * that a userland trampoline can call the actual thread function.
+     */
+    thread_t *make_user_thread(proc_t &proc
+                              ,addr_t  entrypoint
+                              ,addr_t  stack_top
+                              ,u32     eax
+                              ,u32     ebx);
+
     using proc_arg_spec_t = Array<StringView, max_args>;
 
     /**
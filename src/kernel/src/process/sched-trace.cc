@@ -0,0 +1,98 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "sched-trace.hh"
+#include "filesystem/vfs.hh"
+
+namespace Process::Trace {
+
+    static Array<sched_trace_event_t, max_events> events;
+
+    // Both counters only ever increase, the ring index is counter % max_events.
+    static u32 head = 0; ///< Total amount of events recorded.
+    static u32 tail = 0; ///< Total amount of events consumed (or overwritten).
+
+    static bool enabled = true;
+
+    void record(sched_trace_type_t   type
+               ,sched_trace_reason_t reason
+               ,tid_t tid
+               ,pid_t pid
+               ,u32   arg) {
+
+        if (!enabled) return;
+
+        sched_trace_event_t &e = events[head % max_events];
+
+        e.tsc      = asm_rdtsc();
+        e.tid      = tid;
+        e.pid      = pid;
+        e.type     = type;
+        e.reason   = reason;
+        e.reserved = 0;
+        e.arg      = arg;
+
+        ++head;
+
+        // Drop the oldest event if the reader is not keeping up.
+        if (head - tail > max_events)
+            tail = head - max_events;
+    }
+
+    /**
+     * Device /dev/sched-trace.
+     *
+     * Reads consume whole event records. Writing '0' stops tracing, writing
+     * '1' clears the buffer and (re)starts tracing.
+     */
+    struct trace_dev_t : public DevFs::device_t {
+
+        ssize_t read(u64, void *buffer, size_t nbytes) override {
+
+            auto *dst = (sched_trace_event_t*)buffer;
+
+            size_t count = min(nbytes / sizeof(sched_trace_event_t), head - tail);
+
+            for (size_t i : range(count))
+                dst[i] = events[(tail + i) % max_events];
+
+            tail += count;
+
+            return count * sizeof(sched_trace_event_t);
+        }
+
+        ssize_t write(u64, const void *buffer, size_t nbytes) override {
+            if (!nbytes) return 0;
+
+            char c = *(const char*)buffer;
+            if (c == '0') {
+                enabled = false;
+            } else if (c == '1') {
+                tail    = head;
+                enabled = true;
+            } else {
+                return ERR_invalid;
+            }
+            return nbytes;
+        }
+
+        s64 size() override { return (head - tail) * sizeof(sched_trace_event_t); }
+    };
+    static trace_dev_t trace_dev;
+
+    void init() {
+        DevFs *devfs = Vfs::get_devfs();
+        if (devfs) devfs->register_device("sched-trace", trace_dev, 0600);
+    }
+}
@@ -0,0 +1,44 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "common.hh"
+#include <sched-trace.hh>
+
+/**
+ * Scheduler event tracing.
+ *
+ * The scheduler records thread state transitions (dispatches, wakeups,
+ * blocks) in a fixed-size ring buffer. When the buffer is full, the oldest
+ * events are overwritten.
+ *
+ * The buffer is exposed as /dev/sched-trace, see the schedstat program for
+ * a consumer.
+ */
+namespace Process::Trace {
+
+    /// Amount of events kept in the ring buffer.
+    static constexpr size_t max_events = 4_K;
+
+    /// Records a single scheduler event. (interrupts must be disabled)
+    void record(sched_trace_type_t   type
+               ,sched_trace_reason_t reason
+               ,tid_t tid
+               ,pid_t pid
+               ,u32   arg = 0);
+
+    /// Registers /dev/sched-trace (needs to be run after the VFS is initialised).
+    void init();
+}
@@ -17,15 +17,33 @@
 
 using namespace ostd;
 
-int main(int argc, const char **argv) {
+/// Copy fd to stdout.
+static int cat_fd(fd_t fd, Array<char, 512> &buffer) {
+    while (true) {
+        ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n <= 0) {
+            if (n != 0) // not EOF?
+                print(stderr, "read failed: {}\n", error_name(n));
+            return 0;
+        }
 
-    if (argc < 2) {
-        print(stderr, "usage: cat <file>...\n");
-        return 1;
+        n = write(stdout, buffer.data(), n);
+        if (n < 0) {
+            print(stderr, "write failed: {}\n", error_name(n));
+            return 1;
+        }
     }
+}
+
+int main(int argc, const char **argv) {
 
     Array<char, 512> buffer;
 
+    if (argc < 2) {
+        // No files given: Copy stdin (e.g. when used in a pipeline).
+        return cat_fd(stdin, buffer);
+    }
+
     for (int i : range(1, argc)) {
 
         fd_t fd = open(argv[i], "r");
@@ -34,23 +52,9 @@ int main(int argc, const char **argv) {
             return 1;
         }
 
-        // Copy fd to stdout.
-        while (true) {
-            ssize_t n = read(fd, buffer.data(), buffer.size());
-            if (n <= 0) {
-                if (n != 0) // not EOF?
-                    print(stderr, "read failed: {}\n", error_name(n));
-                close(fd);
-                break; // next file.
-            }
-
-            n = write(stdout, buffer.data(), n);
-            if (n < 0) {
-                print(stderr, "write failed: {}\n", error_name(n));
-                return 1;
-            }
-        }
+        int err = cat_fd(fd, buffer);
         close(fd);
+        if (err) return err;
     }
 
     return 0;
@@ -36,17 +36,12 @@ int main(int argc, const char **argv) {
         return 1;
     }
 
-    Array<char, 512> buffer;
+    // The kernel copies the data for us: It does not pass through here.
     while (true) {
-        ssize_t n = read(src, buffer.data(), buffer.size());
+        ssize_t n = copy_range(src, dst, 1024 * 1024);
         if (n <= 0) {
             if (n != 0)
-                print(stderr, "read failed: {}\n", error_name(n));
-            break;
-        }
-        n = write(dst, buffer.data(), n);
-        if (n < 0) {
-            print(stderr, "write failed: {}\n", error_name(n));
+                print(stderr, "copy failed: {}\n", error_name(n));
             break;
         }
     }
@@ -19,10 +19,24 @@ using namespace ostd;
 
 int main(int argc, const char **argv) {
 
-    for (int i : range(1, argc))
-        print("{} ", argv[i]);
+    // Gather arguments and separators, so that the whole line is written at
+    // once (for up to max_iovecs/2 arguments).
+    Array<iovec_t, max_iovecs> iov;
+    size_t count = 0;
 
-    print("\n");
+    for (int i : range(1, argc)) {
+        iov[count++] = { (void*)argv[i], str_length(argv[i]) };
+        iov[count++] = { (void*)(i == argc - 1 ? "\n" : " "), 1 };
+
+        if (count == iov.size() || i == argc - 1) {
+            if (writev(stdout, iov.data(), count) < 0)
+                return 1;
+            count = 0;
+        }
+    }
+
+    if (argc < 2)
+        print("\n");
 
     return 0;
 }
@@ -0,0 +1,74 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "sys.hh"
+
+/**
+ * Asynchronous I/O ring.
+ *
+ * Operations are queued in a ring shared with the kernel and executed, in
+ * order, by a kernel worker thread. Results are posted to a completion ring.
+ * Many operations can thus be performed with a single system call - or none
+ * at all, if the worker is still busy with earlier submissions.
+ *
+ * Only one ring can be set up per process.
+ *
+ * Example:
+ *
+ *     static io_ring_t ring;
+ *     ring.setup();
+ *
+ *     syscall_io_sqe_t *e = ring.next_sqe();
+ *     e->op = io_op_read; e->fd = fd; e->data = buf; e->size = sizeof(buf);
+ *     e->user_data = 1;
+ *
+ *     ring.submit(1); // Submit, and wait for one completion.
+ *
+ *     syscall_io_cqe_t c;
+ *     while (ring.reap(c))
+ *         print("op {}: {}\n", c.user_data, c.result);
+ */
+struct io_ring_t {
+    syscall_io_ring_t shared; ///< (page-aligned, shared with the kernel)
+
+    u32 pending = 0; ///< Entries filled in, but not yet submitted.
+
+    /// Register the ring with the kernel.
+    errno_t setup();
+
+    /**
+     * Get the next free submission entry.
+     *
+     * The entry is cleared, and submitted with the next submit().
+     * \return nullptr if the submission ring is full.
+     */
+    syscall_io_sqe_t *next_sqe();
+
+    /**
+     * Submit all pending entries.
+     *
+     * Enters the kernel only if the worker needs a wakeup, or if
+     * `min_complete` > 0, in which case this waits until that many
+     * completions are available.
+     *
+     * \return the amount of available completions (if the kernel was
+     *         entered), or an error code below 0
+     */
+    ssize_t submit(size_t min_complete = 0);
+
+    /// Take the next completion entry. Returns false if there is none.
+    bool reap(syscall_io_cqe_t &c);
+};
@@ -165,6 +165,50 @@ ssize_t read(fd_t fd, void *p, size_t nbytes);
  */
 ssize_t read_dir(fd_t fd, dir_entry_t &d);
 
+/**
+ * Copy up to `nbytes` from one file to another within the kernel.
+ *
+ * Copying starts at the current position of both files. This is much faster
+ * than reading and writing through a buffer.
+ *
+ * \return the amount of bytes copied (0 at the end of the input file), or an
+ *         error code below 0
+ */
+ssize_t copy_range(fd_t fd_in, fd_t fd_out, size_t nbytes);
+
+/**
+ * Write all modified file data to disk.
+ *
+ * Filesystems may keep written data in memory for a while, so call this
+ * before e.g. turning off the machine.
+ */
+errno_t sync();
+
+/// Write the modified data of an open file to disk.
+errno_t fsync(fd_t fd);
+
+/// File metadata.
+using stat_t = syscall_stat_t;
+
+/// Get the metadata of a file, without opening it.
+errno_t stat(ostd::StringView path, stat_t &st);
+
+/// Get the metadata of an open file.
+errno_t fstat(fd_t fd, stat_t &st);
+
+/// A raw directory entry, as filled by the kernel.
+using dirent_t = syscall_dir_entry_t;
+
+/**
+ * Read as many directory entries as fit into `entries` in one system call.
+ *
+ * This is much faster than read_dir() for large directories.
+ *
+ * \return the amount of entries read (0 at the end of the directory), or an
+ *         error code below 0
+ */
+ssize_t read_dir(fd_t fd, dirent_t *entries, size_t count);
+
 /**
  * Write from a buffer into a file.
  *
@@ -184,6 +228,32 @@ ssize_t read_dir(fd_t fd, dir_entry_t &d);
  */
 ssize_t write(fd_t fd, const void *p, size_t nbytes);
 
+using iovec_t = syscall_iovec_t;
+
+/**
+ * Read from a file into multiple buffers, in order.
+ *
+ * This is a single system call, and a single operation on the file: Useful
+ * for reading e.g. a header and a payload into separate buffers.
+ * At most ostd::max_iovecs buffers can be passed.
+ *
+ * \return the total amount of bytes read (may be lower than the total buffer
+ *         size!) or a value below zero if an error occurred.
+ */
+ssize_t readv(fd_t fd, const iovec_t *iov, size_t count);
+
+/**
+ * Write from multiple buffers into a file, in order.
+ *
+ * This is a single system call, and the data is written as one piece: Writes
+ * by others to the same file do not end up in between.
+ * At most ostd::max_iovecs buffers can be passed.
+ *
+ * \return the total amount of bytes written (may be lower than the total
+ *         buffer size!) or a value below zero if an error occurred.
+ */
+ssize_t writev(fd_t fd, const iovec_t *iov, size_t count);
+
 /**
  * Change the current offset into the file where data is written to or read from.
  *
@@ -195,6 +265,20 @@ ssize_t write(fd_t fd, const void *p, size_t nbytes);
  */
 errno_t seek (fd_t fd, int whence, ssize_t off);
 
+using pollfd_t = syscall_poll_fd_t;
+
+/**
+ * Wait until one or more files are ready for reading or writing.
+ *
+ * For each file, set `events` to poll_in and/or poll_out. On return,
+ * `revents` holds the events that occurred (poll_hup and poll_nval are
+ * reported regardless of `events`).
+ *
+ * \param timeout_ms  time to wait in milliseconds, or -1 to wait indefinitely
+ * \return the amount of ready files (0 on timeout), or an error code below 0
+ */
+ssize_t poll(pollfd_t *fds, size_t count, s32 timeout_ms = -1);
+
 /**
  * Shorthand to keep reading till completion.
  *
@@ -316,14 +400,29 @@ inline ssize_t putchar(         char c) { return putchar(stdout, c); }
 
 template<typename... Args>
 ssize_t print(fd_t fd, ostd::StringView s, const Args&... args) {
+    // Format into a small buffer, so that short messages take a single write.
+    ostd::Array<char, 128> buffer;
+    size_t  used          = 0;
     ssize_t bytes_written = 0;
     errno_t err = 0;
+
+    auto flush = [&] {
+        if (err >= 0 && used) {
+            ssize_t n = write_all(fd, buffer.data(), used);
+            if (n < 0) err = n;
+            else       bytes_written += n;
+        }
+        used = 0;
+    };
+
     ostd::fmt([&](char c) {
-        if (err < 0) return;
-        err = putchar(fd, c);
-        if (err >= 0) bytes_written++;
+        if (used == buffer.size())
+            flush();
+        buffer[used++] = c;
     }, s, args...);
 
+    flush();
+
     return err < 0 ? err : bytes_written;
 }
 
@@ -0,0 +1,99 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "sys.hh"
+#include <os-std/errno.hh>
+
+/**
+ * Message-passing IPC.
+ *
+ * A server creates a (named) port and receives messages from it. Clients
+ * look up the port and send messages to it, or call it and wait for a reply:
+ *
+ *     // Server:
+ *     port_t port = port_create("decoder");
+ *     message_t msg;
+ *     msg.data = request.data(); msg.size = request.size();
+ *     port_receive(port, msg);
+ *     ...
+ *     port_reply(msg.id, reply);
+ *
+ *     // Client:
+ *     port_t port = port_lookup("decoder");
+ *     port_call(port, request, reply);
+ *
+ * All sends block until the message has been received (or replied to).
+ *
+ * Small messages are copied. Large page-aligned payloads are moved by
+ * remapping pages from the sending buffer to the receiving buffer: After a
+ * transfer, the sender's payload buffer is cleared (it never holds data of
+ * the receiver). Use set_payload() to let this be decided automatically.
+ */
+
+using port_t    = int;
+using message_t = syscall_message_t;
+
+/// Create a port. Ports without a name can only be found by their number.
+inline port_t  port_create(ostd::StringView name = "") { return sys_port_create(name); }
+inline errno_t port_destroy(port_t port)               { return sys_port_destroy(port); }
+inline port_t  port_lookup(ostd::StringView name)      { return sys_port_lookup(name);  }
+
+/// Send a message, waiting until it has been received.
+inline errno_t port_send(port_t port, const message_t &msg) { return sys_port_send(port, msg); }
+
+/**
+ * Receive a message.
+ *
+ * On input, msg.data/size and msg.pages/pages_size describe the receive
+ * buffers. On output they describe what was received, msg.id is the ID to
+ * reply to (if the sender is waiting for a reply) and msg.sender is the
+ * sending process.
+ */
+inline errno_t port_receive(port_t port, message_t &msg) { return sys_port_receive(port, msg); }
+
+/// Send a message and wait for the reply (see port_receive for `reply`).
+inline errno_t port_call(port_t port, const message_t &msg, message_t &reply) {
+    return sys_port_call(port, msg, reply);
+}
+
+/// Reply to a call.
+inline errno_t port_reply(u32 id, const message_t &msg) { return sys_port_reply(id, msg); }
+
+/**
+ * Attach a payload to a message.
+ *
+ * Page-aligned buffers of at least ipc_remap_threshold bytes are transferred
+ * by moving pages, anything else is copied inline.
+ */
+inline errno_t set_payload(message_t &msg, void *buffer, size_t size) {
+
+    if (!(((addr_t)buffer | size) & (ostd::page_size - 1))
+     && size >= ostd::ipc_remap_threshold) {
+        msg.pages      = buffer;
+        msg.pages_size = size;
+        msg.data       = nullptr;
+        msg.size       = 0;
+    } else {
+        if (size > ostd::ipc_inline_max)
+            return ostd::ERR_limit;
+
+        msg.data       = buffer;
+        msg.size       = size;
+        msg.pages      = nullptr;
+        msg.pages_size = 0;
+    }
+    return ostd::ERR_success;
+}
@@ -18,8 +18,14 @@
 #include <os-std/string.hh>
 #include <os-std/errno.hh>
 
+/// The kernel data page, mapped read-only by the kernel (see link.ld).
+extern "C" const volatile syscall_kernel_data_t KERNEL_DATA_;
+
 inline tid_t get_tid() { return sys_get_tid(); }
-inline pid_t get_pid() { return sys_get_pid(); }
+
+// These do not need a system call.
+inline pid_t get_pid()      { return KERNEL_DATA_.pid;      }
+inline tid_t get_main_tid() { return KERNEL_DATA_.main_tid; }
 
 constexpr inline fd_t spawn_fd_clear   = -1; // fd in spawned proc will be closed.
 constexpr inline fd_t spawn_fd_inherit = -2; // fd in spawned proc will match parent's stdin/out/err.
@@ -43,6 +49,9 @@ pid_t spawn(ostd::StringView path
     return spawn(path, args.size(), args.data(), do_wait, transplanted_files);
 }
 
+/// Wait until the given process exits.
+inline errno_t wait_pid(pid_t pid) { return sys_wait_pid(pid); }
+
 template<size_t N>
 errno_t get_cwd(ostd::String<N> &path) {
     path = "";
@@ -20,6 +20,70 @@
 #include <os-std/limits.hh>
 #include <os-std/errno.hh>
 
+/// Whether system calls may use SYSENTER (detected at startup, see sys.cc).
+extern bool syscall_sysenter_;
+
+/// Performs a system call using the (always available) `int 0xca` gate.
+inline int syscall_int(u32 a = 0,
+                       u32 b = 0,
+                       u32 c = 0,
+                       u32 d = 0,
+                       u32 e = 0,
+                       u32 f = 0) {
+
+    asm volatile ("int $0xca"
+                 :"+a" (a) // return value is stored in EAX.
+                 :"b"  (b)
+                 ,"c"  (c)
+                 ,"d"  (d)
+                 ,"S"  (e)
+                 ,"D"  (f)
+                 :"cc",
+                  "memory");
+
+    return a;
+}
+
+/**
+ * Performs a system call using SYSENTER.
+ *
+ * SYSENTER/SYSEXIT do not save a return address or stack pointer, and
+ * SYSEXIT clobbers ECX and EDX. We push these on the stack together with
+ * the return address, and pass the kernel a pointer to them in EBP.
+ * The kernel returns to the label with the stack pointer right above the
+ * return address.
+ *
+ * Only use this if syscall_sysenter_ is set.
+ */
+inline int syscall_sysenter(u32 a = 0,
+                            u32 b = 0,
+                            u32 c = 0,
+                            u32 d = 0,
+                            u32 e = 0,
+                            u32 f = 0) {
+
+    asm volatile ("push %%ebp      \n"
+                  "push %%edx      \n"
+                  "push %%ecx      \n"
+                  "push $1f        \n"
+                  "mov  %%esp, %%ebp \n"
+                  "sysenter        \n"
+                  "1:              \n"
+                  "pop  %%ecx      \n"
+                  "pop  %%edx      \n"
+                  "pop  %%ebp      \n"
+                 :"+a" (a)
+                 :"b"  (b)
+                 ,"c"  (c)
+                 ,"d"  (d)
+                 ,"S"  (e)
+                 ,"D"  (f)
+                 :"cc",
+                  "memory");
+
+    return a;
+}
+
 /**
  * Performs a system call.
  *
@@ -34,17 +98,8 @@ inline int syscall(u32 a = 0,
                    u32 e = 0,
                    u32 f = 0) {
 
-    asm volatile ("int $0xca"
-                 :"+a" (a) // return value is stored in EAX.
-                 :"b"  (b)
-                 ,"c"  (c)
-                 ,"d"  (d)
-                 ,"S"  (e)
-                 ,"D"  (f)
-                 :"cc",
-                  "memory");
-
-    return a;
+    return syscall_sysenter_ ? syscall_sysenter(a, b, c, d, e, f)
+                             : syscall_int     (a, b, c, d, e, f);
 }
 
 inline int sys_yield()   {
@@ -83,6 +138,38 @@ inline int sys_read_dir(fd_t fd, syscall_dir_entry_t &buffer) {
     return syscall(SYS_READ_DIR, fd, (addr_t)&buffer, sizeof(buffer));
 }
 
+inline int sys_stat(ostd::StringView path, syscall_stat_t &buffer) {
+    return syscall(SYS_STAT, (addr_t)path.data(), path.length(), (addr_t)&buffer);
+}
+
+inline int sys_fstat(fd_t fd, syscall_stat_t &buffer) {
+    return syscall(SYS_FSTAT, fd, (addr_t)&buffer);
+}
+
+inline int sys_copy_range(fd_t fd_in, fd_t fd_out, size_t nbytes) {
+    return syscall(SYS_COPY_RANGE, fd_in, fd_out, nbytes);
+}
+
+inline int sys_sync() {
+    return syscall(SYS_SYNC);
+}
+
+inline int sys_fsync(fd_t fd) {
+    return syscall(SYS_FSYNC, fd);
+}
+
+inline int sys_get_dents(fd_t fd, syscall_dir_entry_t *buffer, size_t count) {
+    return syscall(SYS_GET_DENTS, fd, (addr_t)buffer, count * sizeof(*buffer));
+}
+
+inline int sys_readv(fd_t fd, const syscall_iovec_t *iov, size_t count) {
+    return syscall(SYS_READV, fd, (addr_t)iov, count);
+}
+
+inline int sys_writev(fd_t fd, const syscall_iovec_t *iov, size_t count) {
+    return syscall(SYS_WRITEV, fd, (addr_t)iov, count);
+}
+
 inline int sys_seek(fd_t fd, int whence, ssize_t off) {
     return syscall(SYS_SEEK, fd, whence, off);
 }
@@ -142,3 +229,55 @@ inline int sys_pipe(fd_t &in, fd_t &out) {
 
     return err;
 }
+
+inline int sys_thread_create(addr_t entrypoint, addr_t stack_top, u32 eax, u32 ebx) {
+    return syscall(SYS_THREAD_CREATE, entrypoint, stack_top, eax, ebx);
+}
+
+inline int sys_futex_wait(const u32 *addr, u32 expected) {
+    return syscall(SYS_FUTEX_WAIT, (addr_t)addr, expected);
+}
+
+inline int sys_futex_wake(const u32 *addr, u32 count) {
+    return syscall(SYS_FUTEX_WAKE, (addr_t)addr, count);
+}
+
+inline int sys_poll(syscall_poll_fd_t *fds, size_t count, s32 timeout_ms) {
+    return syscall(SYS_POLL, (addr_t)fds, count, (u32)timeout_ms);
+}
+
+inline int sys_ring_setup(syscall_io_ring_t &ring) {
+    return syscall(SYS_RING_SETUP, (addr_t)&ring);
+}
+
+inline int sys_ring_enter(size_t min_complete) {
+    return syscall(SYS_RING_ENTER, min_complete);
+}
+
+inline int sys_port_create(ostd::StringView name) {
+    return syscall(SYS_PORT_CREATE, (addr_t)name.data(), name.length());
+}
+
+inline int sys_port_destroy(int port) {
+    return syscall(SYS_PORT_DESTROY, port);
+}
+
+inline int sys_port_lookup(ostd::StringView name) {
+    return syscall(SYS_PORT_LOOKUP, (addr_t)name.data(), name.length());
+}
+
+inline int sys_port_send(int port, const syscall_message_t &msg) {
+    return syscall(SYS_PORT_SEND, port, (addr_t)&msg);
+}
+
+inline int sys_port_receive(int port, syscall_message_t &msg) {
+    return syscall(SYS_PORT_RECEIVE, port, (addr_t)&msg);
+}
+
+inline int sys_port_call(int port, const syscall_message_t &msg, syscall_message_t &reply) {
+    return syscall(SYS_PORT_CALL, port, (addr_t)&msg, (addr_t)&reply);
+}
+
+inline int sys_port_reply(u32 id, const syscall_message_t &msg) {
+    return syscall(SYS_PORT_REPLY, id, (addr_t)&msg);
+}
@@ -0,0 +1,82 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "sys.hh"
+#include <os-std/errno.hh>
+
+/// A thread function. Receives the `arg` passed to thread_create().
+using thread_fn_t = void (*)(void *arg);
+
+/**
+ * Start a new thread within the current process.
+ *
+ * The caller provides the thread's stack, which must stay valid for as long
+ * as the thread runs. The thread exits when `fn` returns.
+ *
+ * Example:
+ *
+ *     static ostd::Array<u8, 16_KiB> stack;
+ *     tid_t tid = thread_create(worker, nullptr, stack.data(), stack.size());
+ *
+ * \return the new thread's ID, or an error code below 0.
+ */
+tid_t thread_create(thread_fn_t fn, void *arg, void *stack, size_t stack_size);
+
+/// Exit the current thread.
+[[noreturn]] void thread_exit();
+
+/**
+ * Mutex.
+ *
+ * Locking and unlocking an uncontended mutex is a single atomic operation;
+ * the kernel is only entered to sleep on or to wake up waiters (futexes).
+ */
+struct mutex_t {
+    /// 0: unlocked, 1: locked, 2: locked and there may be waiters.
+    u32 state = 0;
+
+    void lock();
+    bool try_lock();
+    void unlock();
+};
+
+/**
+ * Condition variable.
+ *
+ * Signalling a condition variable that has no waiters does not enter the kernel.
+ */
+struct cond_t {
+    u32 seq     = 0; ///< Incremented on every signal (the futex word).
+    u32 waiters = 0; ///< Amount of threads in wait().
+
+    /// Atomically unlock `m` and wait for a signal. `m` is locked again on return.
+    /// (as usual, spurious wakeups are possible: re-check your condition)
+    void wait(mutex_t &m);
+
+    void signal();    ///< Wake up one waiting thread.
+    void broadcast(); ///< Wake up all waiting threads.
+};
+
+/// Use RAII to automatically unlock a mutex on scope exit.
+struct locked_within_scope {
+    mutex_t &mut;
+
+    locked_within_scope(const locked_within_scope& ) = delete;
+    locked_within_scope(      locked_within_scope&&) = delete;
+
+     locked_within_scope(mutex_t &m) : mut(m) { mut.lock();   }
+    ~locked_within_scope()                    { mut.unlock(); }
+};
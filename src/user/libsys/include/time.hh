@@ -0,0 +1,42 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "proc.hh"
+
+/**
+ * \name Time
+ *
+ * These read the kernel data page, and do not need a system call.
+ *
+ *@{
+ */
+
+/// Timer ticks since boot.
+u64 get_ticks();
+
+/// Timer ticks per second.
+inline u32 get_tick_hz() { return KERNEL_DATA_.tick_hz; }
+
+/**
+ * Monotonic time since boot, in microseconds.
+ *
+ * Within a timer tick, the time is interpolated using the time stamp
+ * counter, once the kernel has calibrated it (shortly after boot).
+ * Before that, the resolution is one tick.
+ */
+u64 get_time_us();
+
+///@}
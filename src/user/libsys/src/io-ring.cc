@@ -0,0 +1,69 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "io-ring.hh"
+
+#include <os-std/atomic.hh>
+#include <os-std/memory.hh>
+
+using namespace ostd;
+
+errno_t io_ring_t::setup() {
+    pending = 0;
+    return sys_ring_setup(shared);
+}
+
+syscall_io_sqe_t *io_ring_t::next_sqe() {
+    u32 head, tail;
+    atomic_load(shared.sq.head, head);
+    atomic_load(shared.sq.tail, tail);
+
+    if (tail + pending - head >= io_ring_sq_entries)
+        return nullptr;
+
+    syscall_io_sqe_t *e = &shared.sq.entries[(tail + pending++) % io_ring_sq_entries];
+    memset(e, 0, sizeof(*e));
+    return e;
+}
+
+ssize_t io_ring_t::submit(size_t min_complete) {
+    u32 tail;
+    atomic_load(shared.sq.tail, tail);
+
+    // Publish the entries: The worker may pick them up right away.
+    atomic_store(shared.sq.tail, tail + pending);
+    pending = 0;
+
+    u32 flags;
+    atomic_load(shared.sq.flags, flags);
+
+    if (min_complete || (flags & io_ring_need_wakeup))
+        return sys_ring_enter(min_complete);
+
+    return 0;
+}
+
+bool io_ring_t::reap(syscall_io_cqe_t &c) {
+    u32 head, tail;
+    atomic_load(shared.cq.head, head);
+    atomic_load(shared.cq.tail, tail);
+
+    if (head == tail)
+        return false;
+
+    c = shared.cq.entries[head % io_ring_cq_entries];
+    atomic_store(shared.cq.head, head + 1);
+
+    return true;
+}
@@ -51,9 +51,16 @@ errno_t pipe(fd_t &in, fd_t &out) {
     return sys_pipe(in, out);
 }
 
+ssize_t poll(pollfd_t *fds, size_t count, s32 timeout_ms) {
+    return sys_poll(fds, count, timeout_ms);
+}
+
 ssize_t read (fd_t fd,       void *p, size_t nbytes) { return sys_read (fd, p, nbytes); }
 ssize_t write(fd_t fd, const void *p, size_t nbytes) { return sys_write(fd, p, nbytes); }
 
+ssize_t readv (fd_t fd, const iovec_t *iov, size_t count) { return sys_readv (fd, iov, count); }
+ssize_t writev(fd_t fd, const iovec_t *iov, size_t count) { return sys_writev(fd, iov, count); }
+
 ssize_t read_dir(fd_t fd, dir_entry_t &d) {
     syscall_dir_entry_t e;
     ssize_t ret = sys_read_dir(fd, e);
@@ -69,4 +76,18 @@ ssize_t read_dir(fd_t fd, dir_entry_t &d) {
     return ret;
 }
 
+ssize_t copy_range(fd_t fd_in, fd_t fd_out, size_t nbytes) {
+    return sys_copy_range(fd_in, fd_out, nbytes);
+}
+
+errno_t sync()         { return sys_sync();    }
+errno_t fsync(fd_t fd) { return sys_fsync(fd); }
+
+errno_t stat(ostd::StringView path, stat_t &st) { return sys_stat(path, st); }
+errno_t fstat(fd_t fd, stat_t &st)              { return sys_fstat(fd, st); }
+
+ssize_t read_dir(fd_t fd, dirent_t *entries, size_t count) {
+    return sys_get_dents(fd, entries, count);
+}
+
 errno_t seek (fd_t fd, int whence, ssize_t off) { return sys_seek(fd, whence, off); }
@@ -20,6 +20,7 @@ global start_
 global threadpoline_
 
 extern main
+extern syscall_init_
 extern CTORS_START_
 extern CTORS_END_
 extern PROCESS_ARGUMENTS_
@@ -28,6 +29,9 @@ start_:
     ;; Set up the stack.
     mov esp, stack_top
 
+    ;; Decide how to perform system calls (constructors may need them).
+    call syscall_init_
+
     ;; Call constructors of global objects.
     call call_constructors
 
@@ -0,0 +1,34 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "sys.hh"
+
+bool syscall_sysenter_ = false;
+
+/// Detects SYSENTER support. Called from start.asm before anything else runs.
+extern "C" void syscall_init_();
+extern "C" void syscall_init_() {
+    u32 eax = 1, ebx, ecx, edx;
+    asm volatile ("cpuid"
+                 :"+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+
+    u32 family   = (eax >> 8) & 0xf;
+    u32 model    = (eax >> 4) & 0xf;
+    u32 stepping =  eax       & 0xf;
+
+    // The kernel enables SYSENTER whenever the CPU supports it.
+    // (early Pentium Pros report SEP, but do not actually support it)
+    syscall_sysenter_ = (edx & (1 << 11))
+                     && !(family == 6 && model < 3 && stepping < 3);
+}
@@ -0,0 +1,117 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "thread.hh"
+
+#include <os-std/atomic.hh>
+#include <os-std/limits.hh>
+
+using namespace ostd;
+
+/// Thread entrypoint (in start.asm): calls eax with ebx as its argument.
+extern "C" void threadpoline_();
+
+tid_t thread_create(thread_fn_t fn, void *arg, void *stack, size_t stack_size) {
+
+    if (!fn || !stack || stack_size < 64)
+        return ERR_invalid;
+
+    // The stack grows down: start at the (16-byte aligned) top.
+    addr_t top = ((addr_t)stack + stack_size) & ~addr_t(15);
+
+    return sys_thread_create((addr_t)threadpoline_, top, (addr_t)fn, (addr_t)arg);
+}
+
+void thread_exit() {
+    sys_thread_delete(0);
+    while (true);
+}
+
+// Mutex, following "Futexes Are Tricky" (Drepper), mutex #2. {{{
+
+void mutex_t::lock() {
+    u32 c = 0;
+
+    // Fast path: 0 -> 1, no syscall.
+    if (atomic_compare_exchange(state, c, 1u))
+        return;
+
+    // Contended: mark the mutex as having waiters, and sleep until we manage
+    // to grab it.
+    if (c != 2)
+        c = atomic_exchange(state, 2u);
+
+    while (c != 0) {
+        sys_futex_wait(&state, 2);
+        c = atomic_exchange(state, 2u);
+    }
+}
+
+bool mutex_t::try_lock() {
+    u32 c = 0;
+    return atomic_compare_exchange(state, c, 1u);
+}
+
+void mutex_t::unlock() {
+    // 1 -> 0 means nobody was waiting.
+    if (atomic_fetch_sub(state, 1u) != 1) {
+        atomic_store(state, 0u);
+        sys_futex_wake(&state, 1);
+    }
+}
+
+// }}}
+// Condition variable {{{
+
+void cond_t::wait(mutex_t &m) {
+    u32 s;
+    atomic_load(seq, s);
+    atomic_fetch_add(waiters, 1u);
+
+    m.unlock();
+
+    // If a signal came in after we read seq, the futex value no longer
+    // matches and we return immediately.
+    sys_futex_wait(&seq, s);
+
+    atomic_fetch_sub(waiters, 1u);
+
+    // We were woken, so other threads may well be contending for the mutex:
+    // Lock it in the "has waiters" state so that unlock wakes them.
+    u32 c = atomic_exchange(m.state, 2u);
+    while (c != 0) {
+        sys_futex_wait(&m.state, 2);
+        c = atomic_exchange(m.state, 2u);
+    }
+}
+
+void cond_t::signal() {
+    atomic_fetch_add(seq, 1u);
+
+    u32 w;
+    atomic_load(waiters, w);
+    if (w)
+        sys_futex_wake(&seq, 1);
+}
+
+void cond_t::broadcast() {
+    atomic_fetch_add(seq, 1u);
+
+    u32 w;
+    atomic_load(waiters, w);
+    if (w)
+        sys_futex_wake(&seq, intmax<u32>::value);
+}
+
+// }}}
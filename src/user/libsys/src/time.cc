@@ -0,0 +1,59 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "time.hh"
+
+static u64 rdtsc() {
+    u32 hi, lo;
+    asm volatile ("rdtsc" : "=d" (hi), "=a" (lo));
+    return (u64)hi << 32 | lo;
+}
+
+/// Take a consistent snapshot of the kernel data page's time fields.
+static void read_time(u64 &ticks, u64 &tick_tsc, u32 &tsc_per_tick) {
+    u32 seq;
+    do {
+        seq          = KERNEL_DATA_.seq;
+        ticks        = KERNEL_DATA_.ticks;
+        tick_tsc     = KERNEL_DATA_.tick_tsc;
+        tsc_per_tick = KERNEL_DATA_.tsc_per_tick;
+    } while (seq != KERNEL_DATA_.seq);
+}
+
+u64 get_ticks() {
+    u64 ticks, tick_tsc;
+    u32 tsc_per_tick;
+    read_time(ticks, tick_tsc, tsc_per_tick);
+    return ticks;
+}
+
+u64 get_time_us() {
+    u64 ticks, tick_tsc;
+    u32 tsc_per_tick;
+    read_time(ticks, tick_tsc, tsc_per_tick);
+
+    u32 us_per_tick = 1'000'000 / KERNEL_DATA_.tick_hz;
+    u64 us          = ticks * us_per_tick;
+
+    if (tsc_per_tick) {
+        // The tick that follows may be pending: Never run ahead of it.
+        u64 since_tick = rdtsc() - tick_tsc;
+        if (since_tick < tsc_per_tick)
+            us += since_tick * us_per_tick / tsc_per_tick;
+        else
+            us += us_per_tick - 1;
+    }
+
+    return us;
+}
@@ -18,12 +18,9 @@
 using namespace ostd;
 
 /// Creates a "drwx------"-like mode string.
-static String<10> format_mode(const dir_entry_t &e) {
+static String<10> format_mode(ftype_t t, perm_t p) {
     String<10> s = "";
 
-    ftype_t t = e.type;
-    perm_t  p = e.perm;
-
     // File type letter.
     s += t == t_regular ? '-'
        : t == t_dir     ? 'd'
@@ -37,9 +34,42 @@ static String<10> format_mode(const dir_entry_t &e) {
     return s;
 }
 
-/// Prints a listing for a directory.
+/// Prints a listing line for a file.
+template<typename E>
+static void print_entry(const E &entry, StringView name) {
+    if (entry.type == t_dir) {
+        // Print directories with a trailing slash.
+        print("  {6} {} {6 } {}/\n"
+              ,entry.inode_i
+              ,format_mode(entry.type, entry.perm)
+              ,""
+              ,name);
+    } else {
+        print("  {6} {} {4S} {}\n"
+              ,entry.inode_i
+              ,format_mode(entry.type, entry.perm)
+              ,entry.size
+              ,name);
+    }
+}
+
+/// Prints a listing for a directory (or a single file).
 static void list_dir(StringView path) {
 
+    stat_t st;
+    errno_t err = stat(path, st);
+    if (err < 0) {
+        print(stderr, "could not stat <{}>: {}\n"
+             ,path, error_name(err));
+        return;
+    }
+
+    if (st.type != t_dir) {
+        print("  {-6} {-10} {-6} {}\n", "INODE", "MODE", "SIZE", "NAME");
+        print_entry(st, path);
+        return;
+    }
+
     fd_t dir = open(path, "d");
 
     if (dir < 0) {
@@ -50,10 +80,11 @@ static void list_dir(StringView path) {
 
     print("  {-6} {-10} {-6} {}\n", "INODE", "MODE", "SIZE", "NAME");
 
-    dir_entry_t entry;
+    // Read entries in batches.
+    static Array<dirent_t, 32> entries;
 
     while (true) {
-        ssize_t ret = read_dir(dir, entry);
+        ssize_t ret = read_dir(dir, entries.data(), entries.size());
         if (ret < 0) {
             print(stderr, "could not read dir <{}>: {}\n", path, error_name(ret));
             break;
@@ -62,20 +93,8 @@ static void list_dir(StringView path) {
             // End of dir.
             break;
 
-        if (entry.type == t_dir) {
-            // Print directories with a trailing slash.
-            print("  {6} {} {6 } {}/\n"
-                  ,entry.inode_i
-                  ,format_mode(entry)
-                  ,""
-                  ,entry.name);
-        } else {
-            print("  {6} {} {4S} {}\n"
-                  ,entry.inode_i
-                  ,format_mode(entry)
-                  ,entry.size
-                  ,entry.name);
-        }
+        for (ssize_t i : range(ret))
+            print_entry(entries[i], entries[i].name);
     }
 
     close(dir);
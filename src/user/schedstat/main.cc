@@ -0,0 +1,181 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <io.hh>
+#include <os-std/ostd.hh>
+#include <sched-trace.hh>
+
+using namespace ostd;
+
+/**
+ * Summarises the kernel scheduler trace (/dev/sched-trace).
+ *
+ * For every thread seen in the trace, this prints its share of CPU time and
+ * its run-queue latency: the time between becoming ready (enqueue / wakeup)
+ * and actually being dispatched.
+ *
+ * Times are printed in thousands of TSC cycles.
+ */
+
+struct thread_stat_t {
+    tid_t tid = -1;
+    pid_t pid = -1;
+
+    u64 ready_at      = 0; ///< When the thread entered the ready queue (0 if not ready).
+    u64 running_since = 0; ///< When the thread was dispatched (0 if not running).
+
+    u64 run_cycles    = 0;
+    u64 lat_total     = 0;
+    u64 lat_max       = 0;
+    u32 lat_count     = 0;
+
+    u32 switches      = 0;
+    u32 preempts      = 0;
+    u32 blocks        = 0;
+};
+
+static constexpr size_t max_threads = 128;
+
+static Array<thread_stat_t, max_threads> stats;
+static size_t thread_count = 0;
+
+static thread_stat_t *get_stat(const sched_trace_event_t &e) {
+    for (size_t i : range(thread_count)) {
+        if (stats[i].tid == (tid_t)e.tid)
+            return &stats[i];
+    }
+    if (thread_count == max_threads)
+        return nullptr;
+
+    thread_stat_t &s = stats[thread_count++];
+    s.tid = e.tid;
+    s.pid = e.pid;
+    return &s;
+}
+
+static void process(const sched_trace_event_t &e) {
+
+    thread_stat_t *s = get_stat(e);
+    if (!s) return;
+
+    switch (e.type) {
+    case sched_ev_enqueue:
+    case sched_ev_wakeup:
+        if (!s->ready_at)
+            s->ready_at = e.tsc;
+        break;
+
+    case sched_ev_switch_in:
+        if (s->ready_at) {
+            u64 lat = e.tsc - s->ready_at;
+            s->lat_total += lat;
+            s->lat_max    = max(s->lat_max, lat);
+            s->lat_count++;
+            s->ready_at   = 0;
+        }
+        s->running_since = e.tsc;
+        s->switches++;
+        break;
+
+    case sched_ev_switch_out:
+        if (s->running_since) {
+            s->run_cycles   += e.tsc - s->running_since;
+            s->running_since = 0;
+        }
+        if (e.reason == sched_reason_preempt) s->preempts++;
+        break;
+
+    case sched_ev_block:
+        s->blocks++;
+        break;
+    }
+}
+
+int main(int argc, const char **argv) {
+
+    if (argc > 2 || (argc == 2 && StringView(argv[1]) != "-r")) {
+        print(stderr, "usage: schedstat [-r]\n");
+        print(stderr, "  -r: discard the current trace and restart tracing\n");
+        return 1;
+    }
+
+    fd_t fd = open("/dev/sched-trace", argc == 2 ? "w" : "r");
+    if (fd < 0) {
+        print(stderr, "could not open trace device: {}\n", error_name(fd));
+        return 1;
+    }
+
+    if (argc == 2) {
+        ssize_t err = write(fd, '1');
+        if (err < 0)
+            print(stderr, "could not reset trace: {}\n", error_name(err));
+        close(fd);
+        return err < 0;
+    }
+
+    u64 first_tsc = 0;
+    u64 last_tsc  = 0;
+    u32 total     = 0;
+
+    Array<sched_trace_event_t, 64> buffer;
+    while (true) {
+        ssize_t n = read(fd, buffer.data(), sizeof(buffer));
+        if (n <= 0) {
+            if (n != 0)
+                print(stderr, "read failed: {}\n", error_name(n));
+            break;
+        }
+        for (size_t i : range(n / sizeof(sched_trace_event_t))) {
+            if (!first_tsc) first_tsc = buffer[i].tsc;
+            last_tsc = buffer[i].tsc;
+            process(buffer[i]);
+            total++;
+        }
+    }
+    close(fd);
+
+    if (!total || last_tsc <= first_tsc) {
+        print("no scheduler events recorded\n");
+        return 0;
+    }
+
+    u64 span = last_tsc - first_tsc;
+
+    print("{} events over {} kcycles\n\n", total, span / 1000);
+    print("  {-4} {-4} {6} {6} {6} {6} {10} {10}\n"
+         ,"PID", "TID", "CPU%", "SWITCH", "PREEMP", "BLOCK", "LAT-AVG", "LAT-MAX");
+
+    for (size_t i : range(thread_count)) {
+        thread_stat_t &s = stats[i];
+
+        // Account for threads that are still running at the end of the trace.
+        if (s.running_since)
+            s.run_cycles += last_tsc - s.running_since;
+
+        u32 share = s.run_cycles * 1000 / span;
+
+        print("  {4} {4} {4}.{} {6} {6} {6} {10} {10}\n"
+             ,s.pid
+             ,s.tid
+             ,share / 10
+             ,share % 10
+             ,s.switches
+             ,s.preempts
+             ,s.blocks
+             ,s.lat_count ? s.lat_total / s.lat_count / 1000 : 0
+             ,s.lat_max / 1000);
+    }
+
+    return 0;
+}
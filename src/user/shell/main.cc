@@ -126,6 +126,7 @@ static bool handle_builtin(const args_t &args) {
         print("  put <file> <text...> - writes text to a file\n");
         print("  pwd                  - prints working directory\n");
         print("\n.elf programs in the working directory can be executed as commands\n");
+        print("commands can be chained with '|', e.g.: ls | cat\n");
 
     } else if (argv[0] == "pause") {
 
@@ -174,34 +175,132 @@ static bool handle_builtin(const args_t &args) {
 
     } else if (argv[0] == "test") {
 
-        // fd_t in, out;
-        // errno_t err = pipe(in, out);
-        // if (err < 0) {
-        //     print(stderr, "pipe failed: {}\n", error_name(err));
-        //     return true;
-        // }
-
+        // Spawn a shell which reads input from the keyboard instead of UART,
+        // but still prints to the UART.
         fd_t kb = open("/dev/keyboard", "r");
         if (kb < 0) {
             print(stderr, "could not open keyboard: {}\n", error_name(kb));
             return true;
         }
 
-        // Spawn  a shell which reads input from the keyboard instead of UART,
-        // but still prints to the UART.
         Array<StringView, 1> args_ { "shell" };
         spawn("shell.elf", args_, true
              , { kb, spawn_fd_inherit, spawn_fd_inherit });
 
-        // close(in);
-        // close(out);
-
     } else {
         return false;
     }
     return true;
 }
 
+/// Spawn a program, searching the binary directory if needed.
+static pid_t run_program(const StringView *argv
+                        ,size_t argc
+                        ,bool do_wait
+                        ,Array<fd_t, 3> fds = { spawn_fd_inherit
+                                              , spawn_fd_inherit
+                                              , spawn_fd_inherit }) {
+
+    String<max_path_length> bin = argv[0];
+
+    if (!bin.ends_with(".elf")) {
+        // Auto-append '.elf' for convenience.
+        bin += ".elf";
+    }
+
+    // Check where the program lives first: A failed spawn costs a lot more.
+    stat_t st;
+    errno_t err = stat(bin, st);
+
+    if (err == ERR_not_exists && !bin.starts_with("/")) {
+        // Not an absolute path? Try a hard-coded binary search directory.
+        // (we don't have a PATH environment variable)
+        auto tmp = bin;
+        bin = "/disk0p1/bin/";
+        bin += tmp;
+        err = stat(bin, st);
+    }
+
+    pid_t pid = err < 0           ? err
+              : st.type != t_regular ? ERR_type
+              : spawn(bin, argc, argv, do_wait, fds);
+
+    if (pid < 0)
+        print("cannot run <{}>: {}\n", argv[0], error_name(pid));
+
+    return pid;
+}
+
+/**
+ * Run a pipeline, e.g. "ls | cat".
+ *
+ * All programs are started before we wait for any of them, since a writer
+ * may block until its reader consumes data.
+ */
+static void run_pipeline(const args_t &args) {
+    const auto& [argv, argc] = args;
+
+    Array<pid_t, max_args> pids;
+    size_t pid_count = 0;
+
+    fd_t   stdin_fd = spawn_fd_inherit; // Read end of the previous pipe.
+    size_t start    = 0;
+
+    for (size_t i : range(argc + 1)) {
+        if (i < argc && argv[i] != "|")
+            continue;
+
+        bool last = i == argc;
+
+        if (i == start) {
+            print(stderr, "syntax error: empty command in pipeline\n");
+            break;
+        }
+
+        fd_t in  = spawn_fd_inherit;
+        fd_t out = spawn_fd_inherit;
+
+        if (!last) {
+            errno_t err = pipe(in, out);
+            if (err < 0) {
+                print(stderr, "pipe failed: {}\n", error_name(err));
+                break;
+            }
+        }
+
+        // Transplanted fds are moved into the new process, so we only need
+        // to close them ourselves if spawning fails.
+        pid_t pid = run_program(&argv[start], i - start, false
+                               ,{ stdin_fd, out, spawn_fd_inherit });
+        if (pid < 0) {
+            if (stdin_fd >= 0) close(stdin_fd);
+            if (out      >= 0) close(out);
+        } else {
+            pids[pid_count++] = pid;
+        }
+
+        // The next program reads what this one writes.
+        // (if this one failed to start, the next one immediately gets an EOF)
+        stdin_fd = in;
+        start    = i + 1;
+
+        if (last) break;
+    }
+
+    if (stdin_fd >= 0)
+        close(stdin_fd);
+
+    for (size_t i : range(pid_count)) {
+        // Every started stage must have a real PID: waiting on anything
+        // else would keep us from ever returning to the prompt.
+        if (pids[i] <= 0) {
+            print("shell: pipeline stage has no pid ({})\n", pids[i]);
+            continue;
+        }
+        wait_pid(pids[i]);
+    }
+}
+
 static void process_cmdline(cmdline_t &cmdline) {
 
     cmdline.rtrim();
@@ -213,29 +312,15 @@ static void process_cmdline(cmdline_t &cmdline) {
         if (argc && argv[0].length() && argv[0][0] == '#')
             return;
 
-        if (!handle_builtin(args)) {
-
-            String<max_path_length> bin = argv[0];
-
-            if (!bin.ends_with(".elf")) {
-                // Auto-append '.elf' for convenience.
-                bin += ".elf";
-            }
-
-            errno_t err = spawn(bin, argv, true);
-
-            if (err == ERR_not_exists && !bin.starts_with("/")) {
-                // Not an absolute path? Try a hard-coded binary search directory.
-                // (we don't have a PATH environment variable)
-                auto tmp = bin;
-                bin = "/disk0p1/bin/";
-                bin += tmp;
-                err = spawn(bin, argv, true);
+        for (size_t i : range(argc)) {
+            if (argv[i] == "|") {
+                run_pipeline(args);
+                return;
             }
-
-            if (err < 0)
-                print("cannot run <{}>: {}\n", argv[0], error_name(err));
         }
+
+        if (!handle_builtin(args))
+            run_program(argv.data(), argc, true);
     }
 }
 
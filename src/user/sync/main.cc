@@ -0,0 +1,45 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <io.hh>
+#include <os-std/ostd.hh>
+
+using namespace ostd;
+
+int main(int argc, const char **argv) {
+
+    errno_t err = argc > 1 ? ERR_success : sync();
+
+    // With arguments, only the given files are synced.
+    for (int i : range(1, argc)) {
+        fd_t fd = open(argv[i], "r");
+        if (fd < 0) {
+            print(stderr, "could not open <{}>: {}\n", argv[i], error_name(fd));
+            err = fd;
+            continue;
+        }
+
+        errno_t e = fsync(fd);
+        if (e < 0) {
+            print(stderr, "could not sync <{}>: {}\n", argv[i], error_name(e));
+            err = e;
+        }
+        close(fd);
+    }
+
+    if (argc < 2 && err < 0)
+        print(stderr, "sync failed: {}\n", error_name(err));
+
+    return err < 0 ? 1 : 0;
+}
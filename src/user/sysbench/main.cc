@@ -0,0 +1,99 @@
+/* Copyright 2019 Chris Smeele
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <io.hh>
+#include <io-ring.hh>
+#include <proc.hh>
+#include <os-std/ostd.hh>
+
+using namespace ostd;
+
+/**
+ * Measures null system call latency.
+ *
+ * Performs SYS_GET_PID (which does no work in the kernel) many times, using
+ * both the `int 0xca` gate and SYSENTER (if supported), and prints the
+ * average round-trip time in TSC cycles. For reference, it also measures
+ * get_pid(), which reads the kernel data page instead.
+ *
+ * It then compares performing batches of no-op operations through the I/O
+ * ring with performing the same amount of system calls.
+ */
+
+static u64 rdtsc() {
+    u32 hi, lo;
+    asm volatile ("rdtsc" : "=d" (hi), "=a" (lo));
+    return (u64)hi << 32 | lo;
+}
+
+template<typename F>
+static u64 measure(F call, u32 iterations) {
+    // Warm up caches and TLBs.
+    for (u32 i : range(min(iterations, 100u)))
+        call();
+
+    u64 start = rdtsc();
+    for (u32 i : range(iterations))
+        call();
+
+    return (rdtsc() - start) / iterations;
+}
+
+int main(int argc, const char **argv) {
+
+    u32 iterations = 100000;
+
+    if (argc > 2 || (argc == 2 && (!string_to_num(StringView(argv[1]), iterations)
+                                 || !iterations))) {
+        print(stderr, "usage: sysbench [iterations]\n");
+        return 1;
+    }
+
+    u64 t_int = measure([] { syscall_int(SYS_GET_PID); }, iterations);
+    print("int 0xca: {6} cycles/call\n", t_int);
+
+    if (syscall_sysenter_) {
+        u64 t_fast = measure([] { syscall_sysenter(SYS_GET_PID); }, iterations);
+        print("sysenter: {6} cycles/call\n", t_fast);
+    } else {
+        print("sysenter: not supported\n");
+    }
+
+    u64 t_page = measure([] { (void)get_pid(); }, iterations);
+    print("get_pid:  {6} cycles/call (kernel data page)\n", t_page);
+
+    // Batched operations through the I/O ring.
+    static io_ring_t ring;
+    errno_t err = ring.setup();
+    if (err < 0) {
+        print("io ring:  could not set up: {}\n", error_name(err));
+        return 0;
+    }
+
+    constexpr u32 batch = 32;
+
+    u64 t_ring = measure([] {
+        for (u32 i : range(batch))
+            ring.next_sqe()->op = io_op_nop;
+
+        ring.submit(batch);
+
+        syscall_io_cqe_t c;
+        while (ring.reap(c));
+    }, max(iterations / batch, 1u));
+
+    print("io ring:  {6} cycles/op (batches of {})\n", t_ring / batch, batch);
+
+    return 0;
+}